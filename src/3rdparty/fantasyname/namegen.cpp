@@ -21,7 +21,14 @@
 using namespace NameGen;
 
 
-static std::mt19937 rng(static_cast<unsigned int>(std::chrono::high_resolution_clock::now().time_since_epoch().count()));
+static thread_local std::mt19937 rng(static_cast<unsigned int>(std::chrono::high_resolution_clock::now().time_since_epoch().count()));
+
+
+// Reseeds the calling thread's random engine, so that names can be generated reproducibly.
+void NameGen::seed(unsigned int value)
+{
+	rng.seed(value);
+}
 
 
 // https://isocpp.org/wiki/faq/ctors#static-init-order
@@ -263,6 +263,9 @@ public:
 	std::string toString();
 };
 
+// Reseeds the calling thread's random engine, so that names can be generated reproducibly.
+void seed(unsigned int value);
+
 }
 
 std::wstring towstring(const std::string& s);
@@ -0,0 +1,104 @@
+// bench/island-bench.cpp -- Headless benchmark for the runtime island data, timing the compression codec and pathfinding on a generated island.
+// Built as a separate gorp_bench_island binary, which links only the procgen and world data code, and none of the UI or SFML.
+
+// SPDX-FileType: SOURCE
+// SPDX-FileCopyrightText: Copyright 2025 Raine Simmons <gc@gravecat.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>  // EXIT_FAILURE, EXIT_SUCCESS
+#include <iostream>
+
+#include "procgen/island.hpp"
+#include "util/file/compression.hpp"
+#include "util/math/rng.hpp"
+#include "world/island-data.hpp"
+#include "world/pathfinding.hpp"
+
+namespace gorp {
+
+static constexpr unsigned int   BENCH_PATHS =   200;    // The number of random paths to search.
+static constexpr uint32_t       BENCH_SEED =    1;      // The island seed, fixed so the results are comparable between runs.
+
+// Times the compression codec on an island's tile data, and prints the results.
+static void bench_compression(const IslandData &island)
+{
+    const uint32_t tiles = island.size() * island.size();
+    auto report = [](const std::string &name, const void* data, size_t size)
+    { std::cout << name << ": " << compression::benchmark(static_cast<const char*>(data), size) << "\n"; };
+    report("Heights", island.heights().row(0), tiles * sizeof(uint16_t));
+    report("Regions", island.regions().row(0), tiles * sizeof(uint16_t));
+    report("Terrain", island.terrain_map().row(0), tiles * sizeof(uint8_t));
+    report("Coast distances", island.coast_distances().row(0), tiles * sizeof(uint8_t));
+}
+
+// Times pathfinding between random tiles on an island, checking that A* and jump-point search agree with each other and with the regions, and prints
+// the results.
+static void bench_pathfinding(const IslandData &island)
+{
+    std::vector<Vector2u> land;
+    for (unsigned int y = 0; y < island.size(); y++)
+        for (unsigned int x = 0; x < island.size(); x++)
+            if (island.region(x, y) <= IslandData::REGION_MAX) land.push_back({x, y});
+    if (land.size() < 2) throw std::runtime_error("Benchmark island has no land!");
+
+    // Every step costs 1 or sqrt(2) with uniform costs, so both searches must find paths of exactly the same length, if not the same paths.
+    auto path_length = [](const std::vector<Vector2u> &path)
+    {
+        float length = 0.0f;
+        for (size_t i = 1; i < path.size(); i++)
+            length += (path[i].x != path[i - 1].x && path[i].y != path[i - 1].y ? std::sqrt(2.0f) : 1.0f);
+        return length;
+    };
+    auto tile_str = [](Vector2u tile) { return std::to_string(tile.x) + "," + std::to_string(tile.y); };
+
+    // Water is passable with these costs, so any two tiles can be joined, even across regions.
+    constexpr pathfinding::TerrainCosts swimming = { 1, 1, 1, 1, 1, 1, 1 };
+    RNG rng(BENCH_SEED);
+    std::vector<Vector2u> astar_path, jump_path;
+    double astar_time = 0, jump_time = 0;
+    unsigned int same_region = 0;
+    for (unsigned int i = 0; i < BENCH_PATHS; i++)
+    {
+        const Vector2u start = land[rng.get<size_t>(0, land.size() - 1)], goal = land[rng.get<size_t>(0, land.size() - 1)];
+        const std::string pair_str = tile_str(start) + " to " + tile_str(goal);
+        const bool connected = island.region(start.x, start.y) == island.region(goal.x, goal.y);
+        same_region += connected;
+
+        auto start_time = std::chrono::steady_clock::now();
+        const bool astar_found = pathfinding::astar(island, start, goal, astar_path);
+        astar_time += std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+        start_time = std::chrono::steady_clock::now();
+        const bool jump_found = pathfinding::jump_point(island, start, goal, jump_path);
+        jump_time += std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+
+        if (astar_found != connected || jump_found != connected) throw std::runtime_error("Pathfinding disagrees with regions from " + pair_str);
+        if (connected && std::fabs(path_length(astar_path) - path_length(jump_path)) > 0.01f)
+            throw std::runtime_error("A* and jump-point search found paths of different lengths from " + pair_str);
+        if (!pathfinding::find_path(island, start, goal, astar_path, swimming)) throw std::runtime_error("Pathfinding failed across water from " + pair_str);
+    }
+    std::cout << "Pathfinding: " << BENCH_PATHS << " searches (" << same_region << " reachable), A* " <<
+        static_cast<unsigned int>(astar_time * 1000000.0 / BENCH_PATHS) << " us/path, jump-point " <<
+        static_cast<unsigned int>(jump_time * 1000000.0 / BENCH_PATHS) << " us/path\n";
+}
+
+}   // namespace gorp
+
+// Usage: gorp_bench_island
+int main()
+{
+    std::cout << "Generating island " << gorp::IslandProcGen::ISLAND_SIZE_MAX << " with seed " << gorp::BENCH_SEED << ".\n";
+    try
+    {
+        const gorp::IslandData island(gorp::IslandProcGen(gorp::IslandProcGen::ISLAND_SIZE_MAX, gorp::BENCH_SEED));
+        gorp::bench_compression(island);
+        gorp::bench_pathfinding(island);
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Benchmark failed: " << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
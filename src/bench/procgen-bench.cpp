@@ -0,0 +1,131 @@
+// bench/procgen-bench.cpp -- Headless benchmark for island generation, reporting per-stage throughput, peak memory, and a hash of the generated output.
+// Built as a separate gorp_bench_procgen binary, which links only the procgen code and none of the UI or SFML.
+
+// SPDX-FileType: SOURCE
+// SPDX-FileCopyrightText: Copyright 2025 Raine Simmons <gc@gravecat.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <cstdlib>  // EXIT_FAILURE, EXIT_SUCCESS
+#include <iomanip>
+#include <iostream>
+
+#ifdef GORP_TARGET_WINDOWS
+#include <windows.h>
+#include <psapi.h>  // MUST be included AFTER windows.h
+#else
+#include <sys/resource.h>
+#endif
+
+#include "procgen/island.hpp"
+#include "util/math/mathutils.hpp"
+
+namespace gorp {
+
+static constexpr unsigned int   BENCH_SEEDS_DEFAULT =   16; // The default number of seeds to generate for each island size.
+
+// Returns the peak resident memory of this process so far, in kilobytes.
+static uint64_t peak_memory_kb()
+{
+#ifdef GORP_TARGET_WINDOWS
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!K32GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0;
+    return counters.PeakWorkingSetSize / 1024;
+#else
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage)) return 0;
+    return usage.ru_maxrss; // Linux reports this in kilobytes.
+#endif
+}
+
+// Runs the benchmark across every island size, with the specified number of seeds per size. Returns a hash of all generated output.
+static uint64_t run_benchmark(unsigned int seeds)
+{
+    uint64_t result_hash = mathutils::FNV1A_OFFSET_BASIS;
+    std::array<uint64_t, IslandProcGen::STAGE_COUNT> total_stage_times{};
+    uint64_t total_tiles = 0;
+
+    std::cout << std::setw(6) << "size";
+    for (unsigned int s = 0; s < IslandProcGen::STAGE_COUNT; s++)
+        std::cout << std::setw(11) << IslandProcGen::stage_name(static_cast<IslandProcGen::Stage>(s));
+    std::cout << std::setw(11) << "total" << "   (million tiles/sec)\n";
+
+    auto print_row = [](const std::string &label, uint64_t tiles, const std::array<uint64_t, IslandProcGen::STAGE_COUNT> &stage_times)
+    {
+        // Tiles per microsecond is conveniently the same as millions of tiles per second.
+        auto throughput = [tiles](uint64_t us) { return us ? static_cast<double>(tiles) / us : 0.0; };
+        uint64_t total_us = 0;
+        std::cout << std::setw(6) << label << std::fixed << std::setprecision(2);
+        for (auto us : stage_times)
+        {
+            std::cout << std::setw(11) << throughput(us);
+            total_us += us;
+        }
+        std::cout << std::setw(11) << throughput(total_us) << "\n";
+    };
+
+    for (unsigned int size = IslandProcGen::ISLAND_SIZE_MIN; size <= IslandProcGen::ISLAND_SIZE_MAX; size *= 2)
+    {
+        std::array<uint64_t, IslandProcGen::STAGE_COUNT> stage_times{};
+        const uint64_t tiles = static_cast<uint64_t>(size) * size * seeds;
+
+        // Seeds start at 1, as a seed of 0 would be randomized and break the result hash.
+        for (unsigned int seed = 1; seed <= seeds; seed++)
+        {
+            const IslandProcGen island(size, seed);
+            for (unsigned int s = 0; s < IslandProcGen::STAGE_COUNT; s++)
+                stage_times.at(s) += island.stage_time(static_cast<IslandProcGen::Stage>(s));
+            const auto &heights = island.height_map();
+            const auto &sub_island_ids = island.sub_island_ids();
+            const auto &rivers = island.river_map();
+            result_hash = mathutils::fnv1a(heights.data(), heights.storage_size() * sizeof(float), result_hash);
+            result_hash = mathutils::fnv1a(sub_island_ids.data(), sub_island_ids.storage_size() * sizeof(int), result_hash);
+            result_hash = mathutils::fnv1a(rivers.data(), rivers.storage_size() * sizeof(uint8_t), result_hash);
+            for (const auto &poi : island.points_of_interest())
+            {
+                result_hash = mathutils::fnv1a_value(poi.pos.x, result_hash);
+                result_hash = mathutils::fnv1a_value(poi.pos.y, result_hash);
+                result_hash = mathutils::fnv1a_value(static_cast<uint8_t>(poi.type), result_hash);
+            }
+        }
+
+        print_row(std::to_string(size), tiles, stage_times);
+        for (unsigned int s = 0; s < IslandProcGen::STAGE_COUNT; s++)
+            total_stage_times.at(s) += stage_times.at(s);
+        total_tiles += tiles;
+    }
+    print_row("all", total_tiles, total_stage_times);
+    return result_hash;
+}
+
+}   // namespace gorp
+
+// Usage: gorp_bench_procgen [seeds]
+int main(int argc, char** argv)
+{
+    unsigned int seeds = gorp::BENCH_SEEDS_DEFAULT;
+    if (argc > 1)
+    {
+        const int arg_seeds = std::atoi(argv[1]);
+        if (arg_seeds < 1)
+        {
+            std::cerr << "Usage: " << argv[0] << " [seeds]\n";
+            return EXIT_FAILURE;
+        }
+        seeds = arg_seeds;
+    }
+
+    std::cout << "Generating islands " << gorp::IslandProcGen::ISLAND_SIZE_MIN << " to " << gorp::IslandProcGen::ISLAND_SIZE_MAX << ", " << seeds <<
+        " seeds per size.\n";
+    try
+    {
+        const uint64_t result_hash = gorp::run_benchmark(seeds);
+        std::cout << "Peak memory: " << gorp::peak_memory_kb() << " KB\n";
+        std::cout << "Result hash: " << std::hex << std::setw(16) << std::setfill('0') << result_hash << "\n";
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Benchmark failed: " << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -5,6 +5,7 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 
 #include <cstdlib>  // EXIT_SUCCESS, EXIT_FAILURE, std::getenv
+#include <fstream>
 #include <iostream>
 //#include <SFML/System.hpp>
 
@@ -21,6 +22,7 @@
 #include "core/guru.hpp"
 #include "core/prefs.hpp"
 #include "core/terminal/terminal.hpp"
+#include "util/file/archive.hpp"
 #include "util/file/binpath.hpp"
 #include "util/file/fileutils.hpp"
 #include "util/file/yaml.hpp"
@@ -30,7 +32,17 @@
 namespace gorp {
 
 // Constructor, sets up the Core object.
-Core::Core() : game_ptr_(nullptr), guru_ptr_(nullptr), prefs_ptr_(nullptr), terminal_ptr_(nullptr) { }
+Core::Core() : dev_maps_(false), archive_ptr_(nullptr), game_ptr_(nullptr), guru_ptr_(nullptr), prefs_ptr_(nullptr), terminal_ptr_(nullptr) { }
+
+// Checks that the gamedata is the version this build expects.
+void Core::check_gamedata_version()
+{
+    YAML yaml_file;
+    yaml_file.load_string(read_datafile("gorp.yml"), "gorp.yml");
+    if (!yaml_file.is_map() || !yaml_file.key_exists("gorp_gamedata_version")) throw GuruMeditation("gorp.yml: Invalid file format!");
+    const int data_version = std::stoi(std::string(yaml_file.val("gorp_gamedata_version")));
+    if (data_version != GORP_GAMEDATA_VERSION) guru_ptr_->halt("Unexpected gamedata version!", GORP_GAMEDATA_VERSION, data_version);
+}
 
 // Cleans up all Core-managed objects.
 void Core::cleanup()
@@ -39,6 +51,7 @@ void Core::cleanup()
     terminal_ptr_.reset(nullptr);
     guru_ptr_.reset(nullptr);
     prefs_ptr_.reset(nullptr);
+    archive_ptr_.reset(nullptr);
 }
 
 // Returns a reference to the singleton Core object.
@@ -48,13 +61,23 @@ Core& Core::core()
     return the_core;
 }
 
-// Returns the full path to a specified game data file.
-std::string Core::datafile(const std::string file)
+// Returns the full path to a specified file in the gamedata folder.
+std::string Core::datafile(const std::string &file) const
 {
     if (!gamedata_location.size()) throw GuruMeditation("Could not locate valid gamedata folder!");
     return BinPath::merge_paths(gamedata_location, file);
 }
 
+// Checks if a game data file exists, in the mounted archive or the gamedata folder.
+bool Core::datafile_exists(const std::string &file) const
+{
+    if (archive_ptr_) return archive_ptr_->contains(file);
+    return fileutils::file_exists(datafile(file));
+}
+
+// Checks if development maps (procgen previews, etc.) should be rendered.
+bool Core::dev_maps() const { return dev_maps_; }
+
 // Destroys the singleton Core object and ends execution.
 void Core::destroy_core(int exit_code)
 {
@@ -65,9 +88,18 @@ void Core::destroy_core(int exit_code)
     std::exit(exit_code);
 }
 
-// Attempts to locate the gamedata folder.
-void Core::find_gamedata()
+// Mounts the gamedata archive if there is one (and it's allowed), or else attempts to locate the gamedata folder.
+void Core::find_gamedata(bool use_archive)
 {
+    // A single archive only costs one open and one mmap, however many files are in it, which makes a real difference on slow or networked drives.
+    if (use_archive && fileutils::file_exists(BinPath::game_path(GAMEDATA_ARCHIVE)))
+    {
+        archive_ptr_ = std::make_unique<Archive>(GAMEDATA_ARCHIVE);
+        log("Game data archive mounted: " + BinPath::game_path(GAMEDATA_ARCHIVE) + " (" + std::to_string(archive_ptr_->file_count()) + " files)");
+        check_gamedata_version();
+        return;
+    }
+
     const std::string game_path_data = BinPath::game_path("gamedata");
     const std::string game_path_data_gorp_yml = BinPath::merge_paths(game_path_data, "gorp.yml");
     const std::string source_path_data = BinPath::merge_paths(source::SOURCE_DIR, "gamedata");
@@ -84,11 +116,7 @@ void Core::find_gamedata()
         gamedata_location = source_path_data;
     }
     else throw GuruMeditation("Could not locate valid gamedata folder!");
-
-    YAML yaml_file(datafile("gorp.yml"));
-    if (!yaml_file.is_map() || !yaml_file.key_exists("gorp_gamedata_version")) throw GuruMeditation("gorp.yml: Invalid file format!");
-    const int data_version = std::stoi(yaml_file.val("gorp_gamedata_version"));
-    if (data_version != GORP_GAMEDATA_VERSION) guru_ptr_->halt("Unexpected gamedata version!", GORP_GAMEDATA_VERSION, data_version);
+    check_gamedata_version();
 }
 
 // Returns a reference to the Game manager object.
@@ -128,18 +156,31 @@ void Core::init_core(std::vector<std::string> parameters)
     guru_ptr_ = std::make_unique<Guru>();
     try
     {
-        bool headless = false;
+        bool headless = false, pack_data = false;
+#ifdef GORP_BUILD_DEBUG
+        dev_maps_ = true;   // Development maps are on by default in debug builds, and off by default in release builds.
+#endif
         for (auto param : parameters)
         {
             if (param == "-say") headless = true;
+            else if (param == "-devmaps") dev_maps_ = true;
+            else if (param == "-nodevmaps") dev_maps_ = false;
+            else if (param == "-packdata") pack_data = true;
         }
 
-        find_gamedata();
+        // With -packdata, the gamedata folder is packed into a new archive, replacing any existing one, and nothing else happens.
+        find_gamedata(!pack_data);
+        if (pack_data)
+        {
+            const size_t files = ArchiveBuilder().build(gamedata_location, GAMEDATA_ARCHIVE);
+            log("Packed " + std::to_string(files) + " files into " + BinPath::game_path(GAMEDATA_ARCHIVE));
+            destroy_core(EXIT_SUCCESS);
+        }
         if (!headless)
         {
             prefs_ptr_ = std::make_unique<Prefs>();
+            game_ptr_ = std::make_unique<Game>();   // The Game starts loading static data in the background, while the Terminal is set up.
             terminal_ptr_ = std::make_unique<Terminal>();
-            game_ptr_ = std::make_unique<Game>();
         }
     }
     catch(const GuruMeditation &e) { guru_ptr_->halt(e.what(), e.error_a(), e.error_b()); }
@@ -178,6 +219,19 @@ Prefs& Core::prefs() const
     return *prefs_ptr_;
 }
 
+// Reads a game data file, from the mounted archive or the gamedata folder.
+std::string Core::read_datafile(const std::string &file) const
+{
+    if (archive_ptr_) return std::string(archive_ptr_->file(file));
+    const std::string path = datafile(file);
+    std::ifstream file_in(path, std::ios::binary | std::ios::ate);
+    if (!file_in.is_open()) throw std::runtime_error("Cannot open file: " + path);
+    std::string data(static_cast<size_t>(file_in.tellg()), '\0');
+    file_in.seekg(0);
+    if (!file_in.read(data.data(), data.size())) throw std::runtime_error("Cannot read file: " + path);
+    return data;
+}
+
 // Returns a reference to the Terminal handler object.
 Terminal& Core::terminal() const
 {
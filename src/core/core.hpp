@@ -10,6 +10,7 @@
 
 namespace gorp {
 
+class Archive;  // defined in util/file/archive.hpp
 class Game;     // defined in core/game.hpp
 class Guru;     // defined in core/guru.hpp
 class Prefs;    // defined in misc/prefs.hpp
@@ -22,13 +23,15 @@ public:
     static constexpr int    CORE_ERROR =    2;  // Serious errors. Shit is going down.
     static constexpr int    CORE_CRITICAL = 3;  // Critical system failure.
 
-    std::string     datafile(const std::string file);   // Returns the full path to a specified game data file.
+    bool            datafile_exists(const std::string &file) const; // Checks if a game data file exists, in the mounted archive or the gamedata folder.
+    bool            dev_maps() const;           // Checks if development maps (procgen previews, etc.) should be rendered.
     Game&           game() const;               // Returns a reference to the Game manager object.
     Guru&           guru() const;               // Returns a reference to the Guru Meditation error-handling/logging object.
     bool            guru_exists() const;        // Checks if the Guru Meditation object currently exists.
     void            log(const std::string &str, int type = Core::CORE_INFO);    // Logs a message in the system log, or prints it to std::cout.
     void            nonfatal(std::string error, int type);  // Reports a non-fatal error, which will be logged but won't halt execution unless it cascades.
     Prefs&          prefs() const;              // Returns a reference to the Prefs object.
+    std::string     read_datafile(const std::string &file) const;   // Reads a game data file, from the mounted archive or the gamedata folder.
     Terminal&       terminal() const;           // Returns a reference to the Terminal handler object.
 
     static Core&    core(); // Returns a reference to the singleton Core object.
@@ -36,15 +39,21 @@ public:
     void            destroy_core(int exit_code);    // Destroys the singleton Core object and ends execution.
 
 private:
+    static constexpr const char*    GAMEDATA_ARCHIVE =  "gamedata.pak"; // The gamedata archive, relative to the game's path.
     static constexpr int    GORP_GAMEDATA_VERSION = 2;  // The expected version for the gamedata folder.
 
-            Core();             // Constructor, sets up the Core object.
-    void    cleanup();          // Attempts to gracefully clean up memory and subsystems.
-    void    find_gamedata();    // Attempts to locate the gamedata folder.
-    void    great_googly_moogly_its_all_gone_to_shit(); // Applies the most powerful possible method to kill the process, in event of emergency.
+                Core();             // Constructor, sets up the Core object.
+    void        check_gamedata_version();   // Checks that the gamedata is the version this build expects.
+    void        cleanup();          // Attempts to gracefully clean up memory and subsystems.
+    std::string datafile(const std::string &file) const;    // Returns the full path to a specified file in the gamedata folder.
+    // Mounts the gamedata archive if there is one (and it's allowed), or else attempts to locate the gamedata folder.
+    void        find_gamedata(bool use_archive);
+    void        great_googly_moogly_its_all_gone_to_shit(); // Applies the most powerful possible method to kill the process, in event of emergency.
 
+    bool        dev_maps_;          // Whether or not development maps are rendered, set with the -devmaps and -nodevmaps parameters.
     std::string gamedata_location;  // The path of the game's data files.
 
+    std::unique_ptr<Archive>    archive_ptr_;   // Pointer to the mounted gamedata archive, if there is one.
     std::unique_ptr<Game>       game_ptr_;      // Pointer to the Game manager object, which handles the current game state.
     std::unique_ptr<Guru>       guru_ptr_;      // Pointer to the Guru Meditation object, which handles errors and logging.
     std::unique_ptr<Prefs>      prefs_ptr_;     // Pointer to the Prefs object, which records simple user preferences.
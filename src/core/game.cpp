@@ -4,29 +4,41 @@
 // SPDX-FileCopyrightText: Copyright 2025 Raine Simmons <gc@gravecat.com>
 // SPDX-License-Identifier: GPL-3.0-or-later
 
-#include <cstdlib>  // EXIT_SUCCESS
+#include <charconv> // std::from_chars
+#include <cstdlib>  // EXIT_FAILURE, EXIT_SUCCESS
+#include <cstring>  // std::strlen
 
 #include "core/core.hpp"
 #include "core/game.hpp"
+#include "core/prefs.hpp"
 #include "core/terminal/terminal.hpp"
+#include "procgen/island.hpp"
+#include "ui/dev-maps.hpp"
 #include "ui/element.hpp"
 #include "ui/input.hpp"
 #include "ui/messagelog.hpp"
 #include "ui/title.hpp"
+#include "util/file/binpath.hpp"
+#include "util/file/filereader.hpp"
+#include "util/file/fileutils.hpp"
+#include "util/file/save-journal.hpp"
 #include "util/math/random.hpp"
+#include "world/chunk-delta.hpp"
 #include "world/codex.hpp"
-
-#include "procgen/island.hpp"   // temp
+#include "world/island-data.hpp"
+#include "world/world.hpp"
 
 namespace gorp {
 
-Game::Game() : codex_ptr_(nullptr), ui_element_id_counter_(0), ui_input_(0), ui_msglog_(0) { }
+Game::Game() : codex_ptr_(std::make_unique<Codex>()), save_ptr_(nullptr), ui_element_id_counter_(0), ui_input_(0), ui_msglog_(0), world_ptr_(nullptr) { }
 
 // Destructor, cleans up attached classes.
 Game::~Game()
 {
     for (unsigned int i = 0; i < ui_elements_.size(); i++)
         ui_elements_.at(i).reset(nullptr);
+    save_ptr_.reset(nullptr);
+    world_ptr_.reset(nullptr);
     codex_ptr_.reset(nullptr);
 }
 
@@ -41,17 +53,17 @@ uint32_t Game::add_element(std::unique_ptr<Element> element)
 // Starts the game, in the form of a title screen followed by the main game loop.
 void Game::begin()
 {
-    codex_ptr_ = std::make_unique<Codex>();
-
     auto title_screen_ptr = std::make_unique<TitleScreen>();
     const auto result = title_screen_ptr->render();
     title_screen_ptr.reset(nullptr);
     switch(result)
     {
         case TitleScreen::TitleOption::QUIT:
-        case TitleScreen::TitleOption::LOAD_GAME:   // Load game is not yet implemented.
             leave_game();
             break;
+        case TitleScreen::TitleOption::LOAD_GAME:
+            load_game();
+            break;
         case TitleScreen::TitleOption::NEW_GAME:
             new_game();
             break;
@@ -59,6 +71,9 @@ void Game::begin()
     main_loop();
 }
 
+// The ID of the save block holding the changes to a chunk.
+std::string Game::chunk_block_id(Vector2 pos) { return "chunk/" + std::to_string(pos.x) + "," + std::to_string(pos.y); }
+
 // Clears all UI elements.
 void Game::clear_elements()
 {
@@ -140,7 +155,109 @@ void Game::element_to_front(uint32_t id)
 }
 
 // Shuts things down cleanly and exits the game.
-void Game::leave_game() { core().destroy_core(EXIT_SUCCESS); }
+void Game::leave_game()
+{
+    int exit_code = EXIT_SUCCESS;
+    if (save_ptr_)
+    {
+        // A commit that fails keeps its blocks for the next one, so it gets one more try. If that fails too, the game exits with an error, rather than
+        // quitting as though it had been saved.
+        save_game();
+        save_ptr_->wait();
+        if (!save_ptr_->update())
+        {
+            save_ptr_->commit();
+            save_ptr_->wait();
+            if (!save_ptr_->update())
+            {
+                core().log("The game could not be saved before exiting!", Core::CORE_ERROR);
+                exit_code = EXIT_FAILURE;
+            }
+        }
+    }
+    core().destroy_core(exit_code);
+}
+
+// Loads the saved game, or starts a new game if there's nothing to load.
+void Game::load_game()
+{
+    try
+    {
+        save_ptr_ = std::make_unique<SaveJournal>(SAVE_FILENAME);
+        if (save_ptr_->has_block("world"))
+        {
+            const std::string world_block = save_ptr_->read_block("world");
+            FileReader world_reader(world_block.data(), world_block.size());
+            const uint64_t seed = world_reader.read_varint();
+            if (!seed || seed > UINT32_MAX) throw std::runtime_error("Invalid world seed!");
+            Vector2 focus;
+            focus.x = world_reader.read_varint_signed();
+            focus.y = world_reader.read_varint_signed();
+
+            std::vector<std::string> log_lines;
+            if (save_ptr_->has_block("messages"))
+            {
+                const std::string log_block = save_ptr_->read_block("messages");
+                FileReader log_reader(log_block.data(), log_block.size());
+                const uint64_t line_count = log_reader.read_varint();
+                for (uint64_t i = 0; i < line_count; i++)
+                    log_lines.push_back(log_reader.read_string());
+            }
+
+            world_ptr_ = std::make_unique<World>(seed, static_cast<size_t>(prefs().world_memory_mb()) * 1024 * 1024);
+
+            // Chunks aren't saved, only the changes made to them, which are replayed on top of the regenerated chunks as they load. They have to be
+            // restored before the focus is set, so no chunk starts loading without its changes. A damaged chunk block only loses that chunk's changes.
+            const uint64_t param_hash = IslandProcGen::parameter_hash();
+            for (const auto &id : save_ptr_->block_ids("chunk/"))
+            {
+                try
+                {
+                    // The chunk's position is only stored in the block ID, so the ID has to parse back to exactly the same string.
+                    Vector2 pos;
+                    const char* id_end = id.data() + id.size();
+                    const auto x_result = std::from_chars(id.data() + std::strlen("chunk/"), id_end, pos.x);
+                    if (x_result.ec != std::errc() || x_result.ptr == id_end || *x_result.ptr != ',' ||
+                        std::from_chars(x_result.ptr + 1, id_end, pos.y).ec != std::errc() || chunk_block_id(pos) != id)
+                            throw std::runtime_error("Invalid chunk block ID!");
+
+                    const std::string chunk_block = save_ptr_->read_block(id);
+                    FileReader chunk_reader(chunk_block.data(), chunk_block.size());
+                    const uint64_t chunk_seed = chunk_reader.read_varint();
+                    const uint64_t chunk_param_hash = chunk_reader.read_data<uint64_t>();
+                    if (chunk_seed != world_ptr_->chunk_seed(pos))
+                    {
+                        core().log("Discarding changes to chunk " + id + " saved with a different seed.", Core::CORE_WARN);
+                        continue;
+                    }
+                    if (chunk_param_hash != param_hash)
+                        core().log("Chunk " + id + " was changed under different generator parameters; its changes may not line up.", Core::CORE_WARN);
+                    ChunkDelta delta;
+                    delta.load(chunk_reader, World::CHUNK_SIZE * World::CHUNK_SIZE);
+                    world_ptr_->restore_delta(pos, std::move(delta));
+                }
+                catch (const std::exception &e)
+                { core().log("Discarding changes to chunk " + id + ": " + std::string(e.what()), Core::CORE_WARN); }
+            }
+            world_ptr_->set_focus(focus);
+            loaded_log_ = std::move(log_lines);
+            last_save_ = std::chrono::steady_clock::now();
+            return;
+        }
+    }
+    catch (const std::exception &e)
+    {
+        // A save that can't be loaded is moved aside under its own name, so it's kept for a closer look rather than mistaken for a working backup when
+        // the new game starts. If it can't be moved, the error is left to stop the game.
+        save_ptr_.reset(nullptr);
+        world_ptr_.reset(nullptr);
+        std::string error = "Could not load saved game: " + std::string(e.what());
+        const std::string backup = move_save_aside(".bad");
+        if (backup.size()) error += " The save file has been moved to " + backup + ".";
+        core().nonfatal(error, Core::CORE_ERROR);
+    }
+    new_game();
+}
 
 // Returns a reference to the MessageLog object.
 MessageLog& Game::log() const
@@ -156,20 +273,39 @@ void Game::main_loop()
 {
     ui_msglog_ = add_element(std::make_unique<MessageLog>());
     ui_input_ = add_element(std::make_unique<Input>());
-    msg("{G}Welcome, brave adventurer to the perilous realms of {C}GORP{G}!");
-    msg();
-    msg("{R}Lorem ipsum dolor sit amet, consectetur adipiscing elit. Morbi ultricies, felis et ultricies malesuada, quam felis bibendum nulla, in gravida nulla orci quis purus. Nullam sollicitudin id mi sed fermentum. Proin at dolor aliquam, fermentum arcu quis, commodo nisl. In a est elit. Proin egestas nibh eget viverra commodo. Aenean vitae tristique justo. Aliquam tincidunt aliquam neque, eu suscipit ante. Integer vel quam lacinia, viverra erat ac, tincidunt risus.");
-    msg();
-    msg("{Y}Cras luctus purus vitae semper vulputate. Aliquam congue lorem rhoncus pharetra commodo. Donec aliquam enim lacus, sit amet pulvinar purus tristique vel. Duis mattis mollis accumsan. Donec metus metus, mollis nec lectus ac, elementum efficitur enim. Nam sodales viverra purus, quis aliquet tortor lobortis quis. Aenean varius vel erat tincidunt faucibus. Aliquam eleifend nec justo sed lobortis. Morbi id maximus odio. Mauris id auctor arcu. Mauris mattis consectetur magna eget tincidunt. Maecenas fringilla felis sit amet velit tristique, sit amet consectetur odio vulputate. Cras tempus faucibus ex non egestas.");
-    msg();
-    msg("{G}In augue nulla, imperdiet eu faucibus vel, cursus elementum felis. Curabitur lacus ligula, pellentesque sit amet libero sit amet, tempor interdum justo. Duis eleifend nunc eu urna fringilla, eu molestie ipsum commodo. Suspendisse in purus dui. In hendrerit orci leo, quis consequat mi aliquet sit amet. Mauris neque risus, tempus sed nisi ac, varius accumsan erat. Pellentesque sagittis nulla ipsum, sed tristique erat fringilla at. Vestibulum ipsum sem, feugiat at congue sit amet, venenatis in arcu. Maecenas vel mi a est mollis accumsan. Mauris convallis justo interdum, pretium ligula ut, posuere tortor. Aenean sollicitudin sem ac auctor rhoncus. ");
+    if (loaded_log_.size())
+    {
+        for (const auto &line : loaded_log_)
+            msg(line);
+        loaded_log_.clear();
+    }
+    else
+    {
+        msg("{G}Welcome, brave adventurer to the perilous realms of {C}GORP{G}!");
+        msg();
+        msg("{R}Lorem ipsum dolor sit amet, consectetur adipiscing elit. Morbi ultricies, felis et ultricies malesuada, quam felis bibendum nulla, in gravida nulla orci quis purus. Nullam sollicitudin id mi sed fermentum. Proin at dolor aliquam, fermentum arcu quis, commodo nisl. In a est elit. Proin egestas nibh eget viverra commodo. Aenean vitae tristique justo. Aliquam tincidunt aliquam neque, eu suscipit ante. Integer vel quam lacinia, viverra erat ac, tincidunt risus.");
+        msg();
+        msg("{Y}Cras luctus purus vitae semper vulputate. Aliquam congue lorem rhoncus pharetra commodo. Donec aliquam enim lacus, sit amet pulvinar purus tristique vel. Duis mattis mollis accumsan. Donec metus metus, mollis nec lectus ac, elementum efficitur enim. Nam sodales viverra purus, quis aliquet tortor lobortis quis. Aenean varius vel erat tincidunt faucibus. Aliquam eleifend nec justo sed lobortis. Morbi id maximus odio. Mauris id auctor arcu. Mauris mattis consectetur magna eget tincidunt. Maecenas fringilla felis sit amet velit tristique, sit amet consectetur odio vulputate. Cras tempus faucibus ex non egestas.");
+        msg();
+        msg("{G}In augue nulla, imperdiet eu faucibus vel, cursus elementum felis. Curabitur lacus ligula, pellentesque sit amet libero sit amet, tempor interdum justo. Duis eleifend nunc eu urna fringilla, eu molestie ipsum commodo. Suspendisse in purus dui. In hendrerit orci leo, quis consequat mi aliquet sit amet. Mauris neque risus, tempus sed nisi ac, varius accumsan erat. Pellentesque sagittis nulla ipsum, sed tristique erat fringilla at. Vestibulum ipsum sem, feugiat at congue sit amet, venenatis in arcu. Maecenas vel mi a est mollis accumsan. Mauris convallis justo interdum, pretium ligula ut, posuere tortor. Aenean sollicitudin sem ac auctor rhoncus. ");
+    }
 
     // Temp testing code
-    auto ipg = std::make_unique<IslandProcGen>(64);
+    auto island = world().chunk({0, 0});
+    if (core().dev_maps())
+    {
+        devmaps::show_heightmap(*island);
+        devmaps::show_overview(*island, 32);
+        devmaps::show_sub_islands(*island);
+    }
 
     int key = 0;
     while(true)
     {
+        world().update();
+        save_ptr_->update();
+        if (std::chrono::steady_clock::now() - last_save_ >= std::chrono::seconds(AUTOSAVE_SECONDS)) save_game();
+
         // Redraw all UI elements, as needed.
         for (unsigned int i = 0; i < ui_elements_.size(); i++)
         {
@@ -206,9 +342,31 @@ void Game::main_loop()
     }
 }
 
+// Moves the save file aside to the first free filename with the specified suffix, returning the new filename, or an empty string if there's no save file.
+std::string Game::move_save_aside(const std::string &suffix)
+{
+    if (!fileutils::file_exists(BinPath::game_path(SAVE_FILENAME))) return "";
+    std::string backup = std::string(SAVE_FILENAME) + suffix;
+    for (unsigned int i = 2; fileutils::file_exists(BinPath::game_path(backup)); i++)
+        backup = std::string(SAVE_FILENAME) + suffix + std::to_string(i);
+    fileutils::rename_file(BinPath::game_path(SAVE_FILENAME), BinPath::game_path(backup));
+    return backup;
+}
+
 // Sets up for a new game!
 void Game::new_game()
 {
+    fileutils::make_dir(BinPath::game_path("userdata"));
+    fileutils::make_dir(BinPath::game_path("userdata/saves"));
+    save_ptr_.reset(nullptr);
+
+    // The new game's first save would overwrite the old one, so any existing save is kept as a backup instead.
+    const std::string backup = move_save_aside(".old");
+    if (backup.size()) core().log("Previous saved game moved to " + backup + ".");
+    save_ptr_ = std::make_unique<SaveJournal>(SAVE_FILENAME, true);
+    last_save_ = std::chrono::steady_clock::now();
+    world_ptr_ = std::make_unique<World>(random::get<uint32_t>(1, UINT32_MAX), static_cast<size_t>(prefs().world_memory_mb()) * 1024 * 1024);
+    world_ptr_->set_focus({0, 0});
 }
 
 // Processes input from the player.
@@ -219,9 +377,56 @@ void Game::process_input(const std::string &input)
     log().message("");
 }
 
+// Snapshots the game into the save file, which is written on a background thread.
+void Game::save_game()
+{
+    if (!save_ptr_ || !world_ptr_) return;
+    last_save_ = std::chrono::steady_clock::now();
+
+    // Each block is only rewritten if it's changed since the last save, so this is cheap to call often.
+    FileWriter world_block;
+    world_block.open_memory();
+    world_block.write_varint(world_ptr_->seed());
+    world_block.write_varint_signed(world_ptr_->focus().x);
+    world_block.write_varint_signed(world_ptr_->focus().y);
+    save_ptr_->stage_block("world", world_block.take_memory());
+
+    if (ui_msglog_)
+    {
+        FileWriter log_block;
+        log_block.open_memory();
+        const auto &lines = log().lines();
+        log_block.write_varint(lines.size());
+        for (const auto &line : lines)
+            log_block.write_string(line);
+        save_ptr_->stage_block("messages", log_block.take_memory());
+    }
+
+    // Each changed chunk gets its own block, named after its position, holding only its seed, the generator parameters it was made with, and the tiles
+    // that differ from them.
+    const uint64_t param_hash = IslandProcGen::parameter_hash();
+    for (const auto &[pos, delta] : world_ptr_->take_dirty_deltas())
+    {
+        FileWriter chunk_block;
+        chunk_block.open_memory();
+        chunk_block.write_varint(world_ptr_->chunk_seed(pos));
+        chunk_block.write_data<uint64_t>(param_hash);
+        delta.save(chunk_block);
+        save_ptr_->stage_block(chunk_block_id(pos), chunk_block.take_memory());
+    }
+    save_ptr_->commit();
+}
+
 // Returns a new, unique UI element ID.
 uint32_t Game::unique_ui_id() { return ++ui_element_id_counter_; }
 
+// Returns a reference to the World object.
+World& Game::world() const
+{
+    if (!world_ptr_) throw std::runtime_error("Attempt to access null World pointer!");
+    return *world_ptr_;
+}
+
 // A shortcut instead of using core().game()
 Game& game() { return core().game(); }
 
@@ -6,6 +6,8 @@
 
 #pragma once
 
+#include <chrono>
+
 #include "core/global.hpp"
 
 namespace gorp {
@@ -13,9 +15,14 @@ namespace gorp {
 class Codex;        // defined in world/codex.hpp
 class Element;      // defined in ui/element.hpp
 class MessageLog;   // defined in ui/messagelog.hpp
+class SaveJournal;  // defined in util/file/save-journal.hpp
+class World;        // defined in world/world.hpp
 
 class Game {
 public:
+    static constexpr int            AUTOSAVE_SECONDS =  60; // How often the game is saved automatically, in seconds.
+    static constexpr const char*    SAVE_FILENAME =     "userdata/saves/world.sav"; // The save file, relative to the game's path.
+
                 Game();             // Constructor, sets up the game manager.
                 ~Game();            // Destructor, cleans up attached classes.
     uint32_t    add_element(std::unique_ptr<Element> element);  // Adds a new UI element to the screen.
@@ -28,18 +35,29 @@ public:
     void        leave_game();       // Shuts things down cleanly and exits the game.
     MessageLog& log() const;        // Returns a reference to the MessageLog object.
     void        process_input(const std::string &input);    // Processes input from the player.
+    void        save_game();        // Snapshots the game into the save file, which is written on a background thread.
     uint32_t    unique_ui_id();     // Returns a new, unique UI element ID.
+    World&      world() const;      // Returns a reference to the World object.
 
 private:
+    static std::string  chunk_block_id(Vector2 pos);    // The ID of the save block holding the changes to a chunk.
     void    main_loop();        // brøether, may i have the lööps
     void    clear_elements();   // Clears all UI elements.
+    void    load_game();        // Loads the saved game, or starts a new game if there's nothing to load.
+    // Moves the save file aside to the first free filename with the specified suffix, returning the new filename, or an empty string if there's no save
+    // file.
+    static std::string  move_save_aside(const std::string &suffix);
     void    new_game();         // Sets up for a new game!
 
     std::unique_ptr<Codex>  codex_ptr_; // The Codex object, which stores all the static game data in memory, and generates copies of said data.
+    std::chrono::steady_clock::time_point   last_save_; // When the game was last saved.
+    std::vector<std::string>    loaded_log_;    // Message log lines from a loaded save, waiting for the message log to be created.
+    std::unique_ptr<SaveJournal>    save_ptr_;  // The save file for the current game.
     std::vector<std::unique_ptr<Element>>   ui_elements_;   // The UI elements on screen right now.
     uint32_t    ui_element_id_counter_; // The counter for generating unique UI element IDs.
     uint32_t    ui_input_;  // The vector ID of the Input stored in ui_elements_.
     uint32_t    ui_msglog_; // The vector ID of the MessageLog stored in ui_elements_.
+    std::unique_ptr<World>  world_ptr_; // The game world, which streams chunks of the archipelago in and out of memory.
 };
 
 Game&   game(); // A shortcut instead of using core().game()
@@ -0,0 +1,17 @@
+// core/global/guru-exception.cpp -- A custom type of std::exception which can be caught and handled by Guru Meditation, providing extra information.
+// This is kept separate from core/guru.cpp so that headless tools can throw and catch it without linking the rest of the engine.
+
+// SPDX-FileType: SOURCE
+// SPDX-FileCopyrightText: Copyright 2025 Raine Simmons <gc@gravecat.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "core/global/guru-exception.hpp"
+
+namespace gorp {
+
+// Custom exception type, which records error codes that can be rendered in Guru::halt()
+GuruMeditation::GuruMeditation(const std::string &what_arg, int code_a, int code_b) : std::runtime_error(what_arg), error_a_(code_a), error_b_(code_b) { }
+int GuruMeditation::error_a() const { return error_a_; }
+int GuruMeditation::error_b() const { return error_b_; }
+
+}   // namespace gorp
@@ -20,11 +20,6 @@
 
 namespace gorp {
 
-// Custom exception type, which records error codes that can be rendered in Guru::halt()
-GuruMeditation::GuruMeditation(const std::string &what_arg, int code_a, int code_b) : std::runtime_error(what_arg), error_a_(code_a), error_b_(code_b) { }
-int GuruMeditation::error_a() const { return error_a_; }
-int GuruMeditation::error_b() const { return error_b_; }
-
 // This has to be a non-class function because C.
 void guru_intercept_signal(int sig) { core().guru().intercept_signal(sig); }
 
@@ -203,6 +198,7 @@ bool Guru::is_dead() const { return dead_already_; }
 // Logs a message in the system log file.
 void Guru::log(std::string msg, int type)
 {
+    std::lock_guard<std::recursive_mutex> lock(log_mutex_);
     if (!syslog_.is_open()) return;
     if (!lock_stderr_) check_stderr();
 
@@ -8,6 +8,7 @@
 
 #include <ctime>
 #include <fstream>
+#include <mutex>
 #include <sstream>
 
 #include "core/global.hpp"
@@ -40,6 +41,7 @@ private:
     bool                console_ready_;     // Have we fully initialized the console yet?
     bool                dead_already_;      // Have we already died? Is this crash within the Guru subsystem?
     bool                lock_stderr_;       // Whether the stderr-checking code is allowed to run or not.
+    std::recursive_mutex    log_mutex_;     // Serializes writes to the system log, so that background threads can log safely.
     std::stringstream   sferr_buffer_;      // Stringstream buffer used to catch sf::err() error messages.
     std::stringstream   stderr_buffer_;     // Pointer to a stringstream buffer used to catch stderr messages.
     std::streambuf*     stderr_old_;        // The old stderr buffer.
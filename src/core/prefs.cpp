@@ -11,60 +11,65 @@
 namespace gorp {
 
 // Constructor, sets default values.
-Prefs::Prefs() : FileReader(BinPath::game_path("userdata/prefs.dat"), true), FileWriter(), auto_rescale_(true), shader_(true), tile_scale_(2)
+Prefs::Prefs() : FileReader(BinPath::game_path("userdata/prefs.dat"), true), FileWriter(), auto_rescale_(true), shader_(true), tile_scale_(2),
+    world_memory_mb_(256)
 {
-    if (!data_.size())  // No prefs file right now, so go with default values.
+    if (!file_size())   // No prefs file right now, so go with default values.
     {
         core().log("prefs.dat file not found, creating new prefs file.");
         save_prefs();
         return;  
     }
 
-    bool header_good = false;
-    char header = read_data<char>();
-    if (header == 'K')
+    // Sections we don't recognize, and any fields added to the end of a section by a newer build, are skipped rather than treated as errors. Nothing is
+    // applied until the whole file has been read, so a corrupted file leaves every setting at its default.
+    uint64_t flags_a = (auto_rescale_ ? 1 : 0) | (shader_ ? 2 : 0), world_memory_mb = world_memory_mb_;
+    try
     {
-        header = read_data<char>();
-        if (header == '8') header_good = true;
+        if (read_header(PREFS_MAGIC) != PREFS_VERSION) throw std::runtime_error("Unexpected prefs version!");
+        uint32_t tag;
+        size_t length;
+        while (read_section(tag, length))
+        {
+            const size_t section_end = FileReader::position() + length;
+            if (tag == SECTION_OPTIONS)
+            {
+                flags_a = read_varint();
+                world_memory_mb = read_varint();
+            }
+            if (FileReader::position() > section_end) throw std::runtime_error("Prefs section overrun!");
+            skip(section_end - FileReader::position());
+        }
+        if (world_memory_mb > UINT32_MAX) throw std::runtime_error("Invalid world memory budget!");
     }
-    if (!header_good)
+    catch (const std::exception &e)
     {
-        core().log("prefs.dat corrupted or invalid version, creating new prefs file.");
+        core().log("prefs.dat corrupted or invalid version (" + std::string(e.what()) + "), creating new prefs file.");
         clear_data();
         save_prefs();
         return;
     }
-
-    const uint32_t file_ver = read_data<uint32_t>();
-    if (file_ver != PREFS_VERSION)  // If the version doesn't match, we'll just go back to defaults.
-    {
-        clear_data();
-        save_prefs();
-        return;
-    }
-
-    const uint8_t flags_a = read_data<uint8_t>();
+    clear_data();
     auto_rescale_ = flags_a & 1;
     shader_ = flags_a & 2;
+    world_memory_mb_ = static_cast<uint32_t>(world_memory_mb);
 }
 
 // Checks if the tile scale changes automatically when the window resizes.
 bool Prefs::auto_rescale() const { return auto_rescale_; }
 
 // Clears the loaded data once it's been processed.
-void Prefs::clear_data() { data_.clear(); }
+void Prefs::clear_data() { close_reader(); }
 
 // Saves the prefs file to disk.
 void Prefs::save_prefs()
 {
     open_file(BinPath::game_path("userdata/prefs.dat"));
-    write_data<char>('K');
-    write_data<char>('8');
-    write_data<uint32_t>(PREFS_VERSION);
-
-    uint8_t flags_a = (auto_rescale_ ? 1 : 0) | (shader_ ? 2 : 0);
-    write_data<uint8_t>(flags_a);
-
+    write_header(PREFS_MAGIC, PREFS_VERSION);
+    begin_section(SECTION_OPTIONS);
+    write_varint((auto_rescale_ ? 1 : 0) | (shader_ ? 2 : 0));
+    write_varint(world_memory_mb_);
+    end_section();
     close_file();
 }
 
@@ -85,12 +90,23 @@ void Prefs::set_shader(bool shader)
     save_prefs();
 }
 
+// Sets the memory budget for resident world chunks, in megabytes.
+void Prefs::set_world_memory_mb(uint32_t megabytes)
+{
+    if (!megabytes) throw std::runtime_error("Invalid world memory budget!");
+    world_memory_mb_ = megabytes;
+    save_prefs();
+}
+
 // Is the shader enabled?
 bool Prefs::shader() const { return shader_; }
 
 // Retrieves the tile scaling factor.
 int Prefs::tile_scale() const { return tile_scale_; }
 
+// The memory budget for resident world chunks, in megabytes.
+uint32_t Prefs::world_memory_mb() const { return world_memory_mb_; }
+
 // Easier access than calling core().prefs()
 Prefs& prefs() { return core().prefs(); }
 
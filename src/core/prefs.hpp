@@ -14,7 +14,7 @@ namespace gorp {
 
 class Prefs : public FileReader, public FileWriter {
 public:
-    static constexpr uint32_t   PREFS_VERSION = 5;  // The version changes when data files are no longer compatible.
+    static constexpr uint32_t   PREFS_VERSION = 7;  // The version changes when data files are no longer compatible.
 
             Prefs();                        // Constructor, sets default values.
     bool    ascii() const;                  // Checks if we're using ASCII glyphs.
@@ -24,13 +24,19 @@ public:
     void    set_auto_rescale(bool toggle);  // Sets whether or not the tile scale auto-changes on window resize.
     void    set_shader(bool shader);        // Sets the shader on or off.
     void    set_tile_scale(int scale);      // Sets a new tile scale.
+    void    set_world_memory_mb(uint32_t megabytes);    // Sets the memory budget for resident world chunks, in megabytes.
     bool    shader() const;                 // Is the shader enabled?
     int     tile_scale() const;             // Retrieves the tile scaling factor.
+    uint32_t    world_memory_mb() const;    // The memory budget for resident world chunks, in megabytes.
 
 private:
+    static constexpr uint32_t   PREFS_MAGIC =       fileutils::fourcc("GPRF");  // The magic number at the start of the prefs file.
+    static constexpr uint32_t   SECTION_OPTIONS =   fileutils::fourcc("OPTS");  // The section holding the options flags and memory budget.
+
     bool    auto_rescale_;  // Are we auto-rescaling as the window size changes?
     bool    shader_;        // Is the shader enabled or disabled?
     int     tile_scale_;    // The size that tiles are scaled on the screen.
+    uint32_t    world_memory_mb_;   // The memory budget for resident world chunks, in megabytes.
 };
 
 Prefs& prefs(); // Easier access than calling core().prefs()
@@ -6,8 +6,10 @@
 
 #include <cmath>
 #include <cstdlib>  // EXIT_SUCCESS
+#include <future>
 #include <SFML/Graphics/Image.hpp>
 #include <SFML/Graphics/Sprite.hpp>
+#include <SFML/Graphics/Texture.hpp>
 #include <string_view>
 
 #ifdef GORP_TARGET_WINDOWS
@@ -16,6 +18,7 @@
 
 #include "cmake/version.hpp"
 #include "core/core.hpp"
+#include "core/game.hpp"
 #include "core/guru.hpp"
 #include "core/prefs.hpp"
 #include "core/terminal/colour-maps.hpp"
@@ -35,6 +38,10 @@ namespace gorp {
 // Constructor, sets up default values but does not initialize the faux-terminal.
 Terminal::Terminal() : current_frame_(nullptr), previous_frame_(nullptr), sprite_max_(0), window_pixels_({0, 0})
 {
+    // Decoding the PNGs and reading the shader don't need the OpenGL context, so they're done on background threads while the window is created.
+    auto font_image = std::async(std::launch::async, [this] { return load_font(); });
+    auto icon_image = std::async(std::launch::async, [this] { return load_png("ghost"); });
+    auto shader_source = std::async(std::launch::async, [] { return core().read_datafile("misc/shader.glsl"); });
     core().log("Attempting to initialize SFML and create OpenGL context.");
 
     // Define the desired OpenGL context settings.
@@ -73,16 +80,15 @@ Terminal::Terminal() : current_frame_(nullptr), previous_frame_(nullptr), sprite
     sf::Vector2i centered_position((screen_width - window_size.x) / 2, (screen_height - window_size.y) / 2);
     main_window_.setPosition(centered_position);
 
-    sf::Image window_icon = load_png("ghost");
-    main_window_.setIcon(window_icon);
+    main_window_.setIcon(icon_image.get());
 
-    // Load the GLSL shader from the data files.
-    if (!shader_.loadFromFile(core().datafile("misc/shader.glsl"), sf::Shader::Type::Fragment)) throw std::runtime_error("Could not load GLSL shader!");
+    // Compile the GLSL shader from the data files.
+    if (!shader_.loadFromMemory(shader_source.get(), sf::Shader::Type::Fragment)) throw std::runtime_error("Could not load GLSL shader!");
     shader_.setUniform("tex", current_frame_->getTexture());
     shader_.setUniform("textureSize", sf::Vector2f(current_frame_->getSize()));
 
     core().log("SFML initialized successfully.");
-    load_sprites();
+    load_sprites(font_image.get());
     core().log("Bitmap font loaded successfully.");
     core().guru().console_ready(true);
 }
@@ -102,6 +108,32 @@ Window* Terminal::add_window(Vector2u new_size, Vector2 new_pos) {
     return window_stack_.back().get();
 }
 
+// Internal rendering code. Draws a grid of solid-colour tiles as a single texture, rather than one sprite per tile.
+void Terminal::blit(sf::RenderTexture &tex, const std::vector<Colour> &cells, Vector2u size, Vector2 pos)
+{
+    if (!size.x || !size.y) return;
+    if (cells.size() != size.x * size.y) throw GuruMeditation("Invalid blit cell buffer size!", cells.size(), size.x * size.y);
+
+    // Build the pixel buffer at one pixel per tile, then let the sprite scale it up to the tile size.
+    std::vector<uint8_t> pixels(cells.size() * 4);
+    for (unsigned int i = 0; i < cells.size(); i++)
+    {
+        const sf::Color sf_col = (cells[i] == Colour::NONE ? sf::Color::Transparent : tile_colour(cells[i]));
+        pixels[i * 4] = sf_col.r;
+        pixels[i * 4 + 1] = sf_col.g;
+        pixels[i * 4 + 2] = sf_col.b;
+        pixels[i * 4 + 3] = sf_col.a;
+    }
+    const sf::Image image({size.x, size.y}, pixels.data());
+    const sf::Texture texture(image);
+
+    const int scale = prefs().tile_scale();
+    sf::Sprite sprite(texture);
+    sprite.setScale(sf::Vector2f(TILE_SIZE * scale, TILE_SIZE * scale));
+    sprite.setPosition(sf::Vector2f(pos.x * TILE_SIZE * scale, pos.y * TILE_SIZE * scale));
+    tex.draw(sprite);
+}
+
 // Refreshes the terminal after rendering.
 void Terminal::flip(bool update_screen)
 {
@@ -186,7 +218,7 @@ int Terminal::get_key()
         if (event->is<sf::Event::Closed>())
         {
             main_window_.close();
-            core().destroy_core(EXIT_SUCCESS);
+            game().leave_game();    // Saves the game first, if there's one in progress.
         }
         else if (const auto* resized = event->getIf<sf::Event::Resized>())
         {
@@ -260,31 +292,36 @@ int Terminal::get_key()
 // Gets the central column and row of the screen.
 Vector2u Terminal::get_middle() const { return size() / 2; }
 
+// Decodes the bitmap font, and masks out its background. Doesn't touch the OpenGL context, so it's safe on any thread.
+sf::Image Terminal::load_font()
+{
+    core().log("Loading pixel font...");
+    sf::Image image = load_png("font");
+
+    // Apply a transparency mask to any black parts of the image.
+    const sf::Vector2u image_size = image.getSize();
+    for (unsigned int x = 0; x < image_size.x; x++)
+        for (unsigned int y = 0; y < image_size.y; y++)
+            if (image.getPixel({x, y}) == sf::Color(0,0,0))
+                image.setPixel({x, y}, sf::Color(0, 0, 0, 0));
+    return image;
+}
+
 // Loads a PNG from the data files.
 sf::Image Terminal::load_png(const std::string &filename)
 {
     sf::Image image;
-    if (!image.loadFromFile(core().datafile("png/" + filename + ".png"))) throw std::runtime_error("Failed to load image: " + filename);
+    const std::string png = core().read_datafile("png/" + filename + ".png");
+    if (!image.loadFromMemory(png.data(), png.size())) throw std::runtime_error("Failed to load image: " + filename);
     return image;
 }
 
-// Load the sprites from the static data.
-void Terminal::load_sprites()
+// Creates the sprite sheet texture from the decoded bitmap font.
+void Terminal::load_sprites(const sf::Image &font)
 {
-    core().log("Loading pixel font...");
-    sf::Image new_image = load_png("font");
-
-    // Determine the size of the image.
-    sf::Vector2u image_size = new_image.getSize();
+    const sf::Vector2u image_size = font.getSize();
     sprite_sheet_size_ = { image_size.x, image_size.y };
-
-    // Apply a transparency mask to any black parts of the image.
-    for (unsigned int x = 0; x < image_size.x; x++)
-        for (unsigned int y = 0; y < image_size.y; y++)
-            if (new_image.getPixel({x, y}) == sf::Color(0,0,0))
-                new_image.setPixel({x, y}, sf::Color(0, 0, 0, 0));
-
-    if (!sprite_sheet_.loadFromImage(new_image)) throw std::runtime_error("Failed to load texture: font.png");
+    if (!sprite_sheet_.loadFromImage(font)) throw std::runtime_error("Failed to load texture: font.png");
     sprite_max_ = (sprite_sheet_.getSize().x / TILE_SIZE) * (sprite_sheet_.getSize().y / TILE_SIZE);
 }
 
@@ -356,17 +393,7 @@ void Terminal::put(sf::RenderTexture &tex, int ch, Vector2 pos, Colour colour, F
     sprite.setScale(sf::Vector2f(pref.tile_scale(), pref.tile_scale()));
 
     // Set the sprite's colour.
-    if (colour != Colour::NONE)
-    {
-        sf::Color sf_col = ColourMap::colour_to_sf(colour);
-        if (pref.shader())  // Make the colour more vibrant if we're using a shader.
-        {
-            sf_col.r = std::min(255, static_cast<int>(sf_col.r * 1.2f));
-            sf_col.g = std::min(255, static_cast<int>(sf_col.g * 1.2f));
-            sf_col.b = std::min(255, static_cast<int>(sf_col.b * 1.2f));
-        }
-        sprite.setColor(sf_col);
-    }
+    if (colour != Colour::NONE) sprite.setColor(tile_colour(colour));
 
     // Position and scale the sprite, then render it.
     sprite.setPosition(sf::Vector2f((pos.x * TILE_SIZE * pref.tile_scale()) / (half_font ? 2 : 1), pos.y * TILE_SIZE * pref.tile_scale()));
@@ -456,6 +483,19 @@ Vector2u Terminal::size() const
 // Gets the raw size of the screen in pixels, without any adjustments.
 Vector2u Terminal::size_pixels() const { return Vector2u(main_window_.getSize().x, main_window_.getSize().y); }
 
+// Converts a Colour into the sf::Color used for rendering tiles, adjusted for the shader.
+sf::Color Terminal::tile_colour(Colour colour) const
+{
+    sf::Color sf_col = ColourMap::colour_to_sf(colour);
+    if (prefs().shader())   // Make the colour more vibrant if we're using a shader.
+    {
+        sf_col.r = std::min(255, static_cast<int>(sf_col.r * 1.2f));
+        sf_col.g = std::min(255, static_cast<int>(sf_col.g * 1.2f));
+        sf_col.b = std::min(255, static_cast<int>(sf_col.b * 1.2f));
+    }
+    return sf_col;
+}
+
 // Easier access than calling core()->terminal()
 Terminal& terminal() { return core().terminal(); }
 
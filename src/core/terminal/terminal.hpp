@@ -38,15 +38,18 @@ public:
     void    window_to_front(Window* win);
 
 private:
-    // Internal rendering code, called by Window::print() and Window::put(), with the complex part handled by Terminal.
+    // Internal rendering code, called by Window::blit(), Window::print() and Window::put(), with the complex part handled by Terminal.
+    void        blit(sf::RenderTexture &tex, const std::vector<Colour> &cells, Vector2u size, Vector2 pos);
     void        print(sf::RenderTexture &tex, std::string str, Vector2 pos, Colour colour, Font font = Font::NORMAL);
     void        put(sf::RenderTexture &tex, int ch, Vector2 pos, Colour colour, Font font = Font::NORMAL);
 
     // Other functions that are only used internally by Terminal.
     void        flip(bool update_screen = true);    // Refreshes the terminal after rendering. This is called automatically before the event loop.
+    sf::Image   load_font();        // Decodes the bitmap font, and masks out its background. Doesn't touch the OpenGL context, so it's safe on any thread.
     sf::Image   load_png(const std::string &filename);  // Loads a PNG from the data files.
-    void        load_sprites();     // Load the sprites from the static data.
+    void        load_sprites(const sf::Image &font);    // Creates the sprite sheet texture from the decoded bitmap font.
     void        recreate_frames();  // Recreates the frame textures, after the window has resized.
+    sf::Color   tile_colour(Colour colour) const;   // Converts a Colour into the sf::Color used for rendering tiles, adjusted for the shader.
 
     std::unique_ptr<sf::RenderTexture>  current_frame_, previous_frame_; // This is where we render updates to the screen, before applying the shader.
     sf::RenderWindow            main_window_;   // The main render window.
@@ -28,6 +28,9 @@ Window::Window(Vector2u new_size, Vector2 new_pos) : pos_(new_pos), render_textu
 // Destructor, explicitly frees memory used.
 Window::~Window() { render_texture_.reset(nullptr); }
 
+// Draws a grid of solid-colour tiles in one pass, much faster than calling put() with a full block on every tile.
+void Window::blit(const std::vector<Colour> &cells, Vector2u size, Vector2 pos) { terminal().blit(*render_texture_, cells, size, pos); }
+
 // Draws a box around a Window.
 void Window::box(Colour colour)
 {
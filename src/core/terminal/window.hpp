@@ -17,6 +17,7 @@ class Window {
                     Window() = delete;  // No default constructor.
                     Window(Vector2u new_size, Vector2 new_pos = {0, 0}); // Creates a new Window of the specified size and position.
                     ~Window();  // Destructor, explicitly frees memory used.
+        void        blit(const std::vector<Colour> &cells, Vector2u size, Vector2 pos = {0, 0});   // Draws a grid of solid-colour tiles in one pass.
         void        box(Colour colour = Colour::WHITE); // Draws a box around a Window.
         void        clear(Colour col = Colour::BLACK);  // Clears/fills a Window.
         Vector2u    get_middle() const; // Gets the central column and row of this Window.
@@ -0,0 +1,133 @@
+// procgen/island-cache.cpp -- On-disk cache of generated islands, keyed by seed, size and generator parameters, and compressed on disk.
+
+// SPDX-FileType: SOURCE
+// SPDX-FileCopyrightText: Copyright 2025 Raine Simmons <gc@gravecat.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <utility>  // std::move
+
+#include "core/core.hpp"
+#include "procgen/island.hpp"
+#include "procgen/island-cache.hpp"
+#include "util/file/binpath.hpp"
+#include "util/file/filereader.hpp"
+#include "util/file/fileutils.hpp"
+#include "util/text/stringutils.hpp"
+#include "world/island-data.hpp"
+
+namespace gorp {
+
+// The cache file is a header written by FileWriter::write_header(), then the island's parameters, then each tile array compressed with
+// FileWriter::write_compressed(), and finally the points of interest. Most of each island is open water, so the region IDs, terrain and coast
+// distances compress very well, and decompressing them is much faster than reading the raw arrays from disk.
+//
+//  uint64_t    IslandProcGen::parameter_hash()
+//  uint32_t    seed
+//  uint16_t    size
+//  uint16_t    region count
+//  compressed  quantized heights, region IDs, packed terrain bytes, coast distances
+//  uint32_t    point of interest count, then for each: uint16_t x, uint16_t y, uint16_t region, uint8_t type
+
+// Loads an island from the cache, or generates (and caches) it on a miss.
+std::unique_ptr<IslandData> IslandCache::get(uint16_t size, uint32_t seed)
+{
+    // Islands generated with a random seed are not cached, as they can never be requested again by key.
+    if (!seed) return std::make_unique<IslandData>(IslandProcGen(size));
+
+    auto island = load(size, seed);
+    if (island) return island;
+    const IslandProcGen generated(size, seed);
+    core().log(generated.timing_report());
+    island = std::make_unique<IslandData>(generated);
+    try { save(*island); }
+    catch (const std::exception &e) { core().nonfatal("Could not cache island: " + std::string(e.what()), Core::CORE_WARN); }
+    return island;
+}
+
+// The cache filename for a given island, relative to the game's path.
+std::string IslandCache::filename(uint16_t size, uint32_t seed) const
+{
+    const uint64_t params = IslandProcGen::parameter_hash();
+    return "userdata/islands/" + stringutils::itoh(seed, 8) + "-" + std::to_string(size) + "-" + stringutils::itoh(params >> 32, 8) +
+        stringutils::itoh(params & 0xFFFFFFFF, 8) + ".dat";
+}
+
+// Attempts to load an island from the cache. Returns nullptr on a miss.
+std::unique_ptr<IslandData> IslandCache::load(uint16_t size, uint32_t seed)
+{
+    const std::string full_path = BinPath::game_path(filename(size, seed));
+    if (!fileutils::file_exists(full_path)) return nullptr;
+
+    // Anything unexpected is treated as a miss, and the file will be overwritten.
+    try
+    {
+        FileReader file(full_path);
+        if (file.read_header(ISLAND_CACHE_MAGIC) != ISLAND_CACHE_VERSION) return nullptr;
+        file.require(sizeof(uint64_t) + sizeof(uint32_t) + (sizeof(uint16_t) * 2));
+        const uint64_t params = file.read_data_unchecked<uint64_t>();
+        const uint32_t file_seed = file.read_data_unchecked<uint32_t>();
+        const uint16_t file_size = file.read_data_unchecked<uint16_t>();
+        const uint16_t region_count = file.read_data_unchecked<uint16_t>();
+        if (params != IslandProcGen::parameter_hash() || file_seed != seed || file_size != size) return nullptr;
+
+        const uint32_t tiles = size * size;
+        std::vector<uint16_t> heights(tiles), regions(tiles);
+        std::vector<uint8_t> terrain(tiles), coast_distances(tiles);
+        file.read_compressed(heights.data(), tiles * sizeof(uint16_t));
+        file.read_compressed(regions.data(), tiles * sizeof(uint16_t));
+        file.read_compressed(terrain.data(), tiles * sizeof(uint8_t));
+        file.read_compressed(coast_distances.data(), tiles * sizeof(uint8_t));
+
+        const uint32_t poi_count = file.read_data<uint32_t>();
+        if (file.remaining() != static_cast<size_t>(poi_count) * POI_ENTRY_SIZE) return nullptr;
+        std::vector<PointOfInterest> points_of_interest(poi_count);
+        for (uint32_t i = 0; i < poi_count; i++)
+        {
+            const uint16_t x = file.read_data_unchecked<uint16_t>();
+            const uint16_t y = file.read_data_unchecked<uint16_t>();
+            const uint16_t region = file.read_data_unchecked<uint16_t>();
+            const uint8_t type = file.read_data_unchecked<uint8_t>();
+            if (x >= size || y >= size || type > static_cast<uint8_t>(PoiType::DUNGEON)) return nullptr;
+            points_of_interest.at(i) = {{x, y}, region, static_cast<PoiType>(type)};
+        }
+        return std::make_unique<IslandData>(seed, size, region_count, std::move(heights), std::move(regions), std::move(terrain), std::move(coast_distances),
+            std::move(points_of_interest));
+    }
+    catch (const std::exception &e)
+    {
+        core().log("Could not load cached island: " + std::string(e.what()), Core::CORE_WARN);
+        return nullptr;
+    }
+}
+
+// Writes an island to the cache.
+void IslandCache::save(const IslandData &island)
+{
+    const std::string cache_file = filename(island.size(), island.seed());
+    fileutils::make_dir(BinPath::game_path("userdata"));
+    fileutils::make_dir(BinPath::game_path("userdata/islands"));
+
+    open_temp_file(cache_file);
+    write_header(ISLAND_CACHE_MAGIC, ISLAND_CACHE_VERSION);
+    write_data<uint64_t>(IslandProcGen::parameter_hash());
+    write_data<uint32_t>(island.seed());
+    write_data<uint16_t>(island.size());
+    write_data<uint16_t>(island.region_count());
+
+    const uint32_t tiles = island.size() * island.size();
+    write_compressed(island.heights().row(0), tiles * sizeof(uint16_t));
+    write_compressed(island.regions().row(0), tiles * sizeof(uint16_t));
+    write_compressed(island.terrain_map().row(0), tiles * sizeof(uint8_t));
+    write_compressed(island.coast_distances().row(0), tiles * sizeof(uint8_t));
+    write_data<uint32_t>(island.points_of_interest().size());
+    for (const auto &poi : island.points_of_interest())
+    {
+        write_data<uint16_t>(poi.pos.x);
+        write_data<uint16_t>(poi.pos.y);
+        write_data<uint16_t>(poi.region);
+        write_data<uint8_t>(static_cast<uint8_t>(poi.type));
+    }
+    replace_file(cache_file);
+}
+
+}   // namespace gorp
@@ -0,0 +1,31 @@
+// procgen/island-cache.hpp -- On-disk cache of generated islands, keyed by seed, size and generator parameters, and compressed on disk.
+
+// SPDX-FileType: SOURCE
+// SPDX-FileCopyrightText: Copyright 2025 Raine Simmons <gc@gravecat.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include "core/global.hpp"
+#include "util/file/filewriter.hpp"
+
+namespace gorp {
+
+class IslandData;   // defined in world/island-data.hpp
+
+class IslandCache : public FileWriter {
+public:
+    static constexpr uint32_t   ISLAND_CACHE_MAGIC =    fileutils::fourcc("GIC1");  // Identifies an island cache file.
+    static constexpr uint32_t   ISLAND_CACHE_VERSION =  4;  // The version changes when cache files are no longer compatible.
+
+    std::unique_ptr<IslandData> get(uint16_t size, uint32_t seed = 0);  // Loads an island from the cache, or generates (and caches) it on a miss.
+    std::unique_ptr<IslandData> load(uint16_t size, uint32_t seed);     // Attempts to load an island from the cache. Returns nullptr on a miss. Thread-safe.
+    void    save(const IslandData &island); // Writes an island to the cache.
+
+private:
+    static constexpr uint32_t   POI_ENTRY_SIZE =    7;  // The size of each point of interest stored after the tile data.
+
+    std::string filename(uint16_t size, uint32_t seed) const;   // The cache filename for a given island, relative to the game's path.
+};
+
+}   // namespace gorp
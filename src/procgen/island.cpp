@@ -4,248 +4,516 @@
 // SPDX-FileCopyrightText: Copyright 2025 Raine Simmons <gc@gravecat.com>
 // SPDX-License-Identifier: GPL-3.0-or-later
 
+#include <algorithm>
+#include <chrono>
 #include <cmath>
 
 #include "3rdparty/PerlinNoise/PerlinNoise.hpp"
-#include "core/game.hpp"
 #include "procgen/island.hpp"
-#include "ui/dev-canvas.hpp"
+#include "util/math/bucket-queue.hpp"
+#include "util/math/distance-field.hpp"
 #include "util/math/mathutils.hpp"
+#include "util/math/poisson-disc.hpp"
 #include "util/math/random.hpp"
-
-#include "core/core.hpp"
+#include "util/math/rng.hpp"
+#include "util/math/stencil.hpp"
+#include "util/system/parallel.hpp"
 
 namespace gorp {
 
-// Generates a new island of the specified size.
-IslandProcGen::IslandProcGen(uint16_t size, uint32_t seed) : seed_(seed), size_(size)
+// Generates a new island of the specified size, with an optional PRNG seed and generation parameters.
+IslandProcGen::IslandProcGen(uint16_t size, unsigned int seed, const IslandParams &params) : first_dirty_(0), params_(params), seed_(seed), size_(size),
+    stage_times_{}
 {
     if (!seed) seed_ = random::get<uint32_t>(INT_MAX);
     if (size < ISLAND_SIZE_MIN || size > ISLAND_SIZE_MAX) throw GuruMeditation("Invalid island size!", size, ISLAND_SIZE_MAX);
-
-    generate_heightmap();
-    determine_sub_islands();
+    generate();
 }
 
-// Determines which land-masses are contiguous, and defines these as sub-islands.
-void IslandProcGen::determine_sub_islands()
+// Generates a new island of the specified size, taking its seed from the "island" stream of the given RNG.
+IslandProcGen::IslandProcGen(uint16_t size, const RNG &rng, const IslandParams &params) : IslandProcGen(size, seed_from_rng(rng), params) { }
+
+// Read-only access to the Euclidean distance from each tile to the nearest land tile (0 on land).
+const Grid2D<float>& IslandProcGen::distance_to_land() const { return distance_to_land_; }
+
+// Read-only access to the Euclidean distance from each tile to the nearest water tile (0 on water).
+const Grid2D<float>& IslandProcGen::distance_to_water() const { return distance_to_water_; }
+
+// Read-only access to the flow accumulation map.
+const Grid2D<uint32_t>& IslandProcGen::flow_map() const { return flow_map_; }
+
+// Simulates erosion droplets within a single block of eroded_map_. Droplets never leave the block, so separate blocks can run in parallel.
+void IslandProcGen::erode_block(Vector2u min, Vector2u max, uint32_t droplets, RNG rng)
 {
-    // If we're generating dev maps, we need to create a new canvas here.
-    DevCanvas* canvas_ptr = nullptr;
-    if (GENERATE_DEV_MAPS)
+    Grid2D<float> &map = eroded_map_;
+
+    // Samples the height and gradient at a point between tiles, by bilinear interpolation.
+    auto sample = [&map](float px, float py, float &height, float &grad_x, float &grad_y)
     {
-        uint32_t canvas_id = game().add_element(std::make_unique<DevCanvas>(Vector2u(size_, size_)));
-        DevCanvas& canvas_ref = static_cast<DevCanvas&>(game().element(canvas_id));
-        canvas_ptr = &canvas_ref;
-    }
-    
-    sub_island_id_.resize(size_ * size_, SUB_ISLAND_ID_UNDEFINED);
-    unsigned int current_sub_id = 0;
-    for (unsigned int x = 0; x < size_; x++)
+        const uint32_t cx = static_cast<uint32_t>(px), cy = static_cast<uint32_t>(py);
+        const float fx = px - cx, fy = py - cy;
+        const float h00 = map(cx, cy), h10 = map(cx + 1, cy), h01 = map(cx, cy + 1), h11 = map(cx + 1, cy + 1);
+        grad_x = ((h10 - h00) * (1.0f - fy)) + ((h11 - h01) * fy);
+        grad_y = ((h01 - h00) * (1.0f - fx)) + ((h11 - h10) * fx);
+        height = (h00 * (1.0f - fx) * (1.0f - fy)) + (h10 * fx * (1.0f - fy)) + (h01 * (1.0f - fx) * fy) + (h11 * fx * fy);
+    };
+
+    // Adds (or removes, if negative) material at a point between tiles, spread across the four surrounding tiles.
+    auto deposit = [&map](float px, float py, float amount)
     {
-        for (unsigned int y = 0; y < size_; y++)
+        const uint32_t cx = static_cast<uint32_t>(px), cy = static_cast<uint32_t>(py);
+        const float fx = px - cx, fy = py - cy;
+        map(cx, cy) += amount * (1.0f - fx) * (1.0f - fy);
+        map(cx + 1, cy) += amount * fx * (1.0f - fy);
+        map(cx, cy + 1) += amount * (1.0f - fx) * fy;
+        map(cx + 1, cy + 1) += amount * fx * fy;
+    };
+
+    // Droplets must stay far enough inside the block that all four of the tiles around them are in the block too.
+    const float min_x = min.x, min_y = min.y, max_x = max.x - 1, max_y = max.y - 1;
+    if (max_x <= min_x || max_y <= min_y) return;
+    for (uint32_t d = 0; d < droplets; d++)
+    {
+        float px = rng.get(min_x, max_x), py = rng.get(min_y, max_y);
+        float dir_x = 0.0f, dir_y = 0.0f, speed = 1.0f, water = 1.0f, sediment = 0.0f;
+        float height, grad_x, grad_y;
+        sample(px, py, height, grad_x, grad_y);
+        if (height <= HEIGHT_MAP_WATER) continue;   // No point raining on the sea.
+
+        for (int step = 0; step < EROSION_DROPLET_LIFETIME; step++)
         {
-            const uint32_t index = mathutils::array_index({x, y}, {size_, size_});
-            const float height = height_map_.at(index);
-            if (height <= HEIGHT_MAP_WATER)
+            // Roll downhill, keeping a little momentum.
+            dir_x = (dir_x * EROSION_INERTIA) - (grad_x * (1.0f - EROSION_INERTIA));
+            dir_y = (dir_y * EROSION_INERTIA) - (grad_y * (1.0f - EROSION_INERTIA));
+            const float length = std::sqrt((dir_x * dir_x) + (dir_y * dir_y));
+            if (length <= 0.0f) break;
+            dir_x /= length;
+            dir_y /= length;
+            const float new_x = px + dir_x, new_y = py + dir_y;
+            if (new_x < min_x || new_x >= max_x || new_y < min_y || new_y >= max_y) break;
+
+            float new_height, new_grad_x, new_grad_y;
+            sample(new_x, new_y, new_height, new_grad_x, new_grad_y);
+            const float delta = new_height - height;
+
+            // Going uphill, or carrying more than it can hold: drop some sediment. Otherwise, pick some up, but never dig deeper than the drop ahead.
+            const float capacity = std::max(-delta, EROSION_MIN_SLOPE) * speed * water * EROSION_CAPACITY;
+            if (delta > 0.0f || sediment > capacity)
             {
-                sub_island_id_.at(index) = SUB_ISLAND_ID_WATER;
-                continue;
+                const float amount = (delta > 0.0f ? std::min(delta, sediment) : (sediment - capacity) * EROSION_DEPOSIT_RATE);
+                sediment -= amount;
+                deposit(px, py, amount);
+            }
+            else
+            {
+                const float amount = std::min((capacity - sediment) * EROSION_ERODE_RATE, -delta);
+                sediment += amount;
+                deposit(px, py, -amount);
             }
-            else if (sub_island_id_.at(index) == SUB_ISLAND_ID_UNDEFINED) floodfill_sub_islands({x, y}, current_sub_id++, canvas_ptr);
-        }
-    }
 
-    // Remove any islands deemed too small.
-    for (unsigned int i = 0; i < sub_island_coords_.size(); i++)
-    {
-        if (sub_island_coords_.at(i).size() < SUB_ISLAND_MIN_SIZE)
-        {
-            erase_sub_island(i, canvas_ptr);
-            i--;
+            speed = std::sqrt(std::max(0.0f, (speed * speed) - (delta * EROSION_GRAVITY)));
+            water *= 1.0f - EROSION_EVAPORATION;
+            px = new_x;
+            py = new_y;
+            height = new_height;
+            grad_x = new_grad_x;
+            grad_y = new_grad_y;
+            if (height <= HEIGHT_MAP_WATER) break;  // Reached the sea; any remaining sediment is lost.
         }
     }
 }
 
-// Erases a specified sub-island, reassigning other IDs.
-void IslandProcGen::erase_sub_island(unsigned int id, DevCanvas* canvas_ptr)
+// Runs any stages that have been invalidated since the last generation.
+void IslandProcGen::generate()
 {
-    std::vector<Vector2u> &coords = sub_island_coords_.at(id);
+    for (unsigned int i = first_dirty_; i < STAGE_COUNT; i++)
+        run_stage(static_cast<Stage>(i));
+    first_dirty_ = STAGE_COUNT;
+}
 
-    // Mark all of the coordinates of the sub-island as too small, and update the dev map if needed.
-    for (auto coord : coords)
-    {
-        const uint32_t index = mathutils::array_index(coord, {size_, size_});
-        sub_island_id_.at(index) = SUB_ISLAND_ID_TOO_SMALL;
-        if (GENERATE_DEV_MAPS && canvas_ptr)
-            canvas_ptr->put(Glyph::FULL_BLOCK, Vector2(coord.x, coord.y), Colour::GRAY_DARK);
-    }
+// Read-only access to the generated height map.
+const Grid2D<float>& IslandProcGen::height_map() const { return height_map_; }
 
-    // Erase the sub-island's coordinates from the vector.
-    sub_island_coords_.erase(sub_island_coords_.begin() + id);
+// Marks a stage, and every stage after it, as needing to be rerun.
+void IslandProcGen::invalidate(Stage stage) { first_dirty_ = std::min(first_dirty_, static_cast<unsigned int>(stage)); }
 
-    // Reassign all other island IDs.
-    for (unsigned int i = 0; i < size_ * size_; i++)
-        if (sub_island_id_.at(i) > static_cast<int>(id)) sub_island_id_.at(i)--;
+// A hash of every parameter that affects the generated output, used to key cached islands.
+uint64_t IslandProcGen::parameter_hash(const IslandParams &params)
+{
+    uint64_t hash = mathutils::fnv1a_value(ISLAND_GENERATOR_VERSION);
+    hash = mathutils::fnv1a_value(params.border_modifier_inner, hash);
+    hash = mathutils::fnv1a_value(params.border_modifier_outer, hash);
+    hash = mathutils::fnv1a_value(params.dungeon_spacing, hash);
+    hash = mathutils::fnv1a_value(params.erosion_droplets, hash);
+    hash = mathutils::fnv1a_value(params.island_height_modifier, hash);
+    hash = mathutils::fnv1a_value(params.perlin_octaves, hash);
+    hash = mathutils::fnv1a_value(params.perlin_zoom, hash);
+    hash = mathutils::fnv1a_value(params.river_flow_min, hash);
+    hash = mathutils::fnv1a_value(params.settlement_spacing, hash);
+    hash = mathutils::fnv1a_value(params.sub_island_min_size, hash);
+    hash = mathutils::fnv1a_value(HEIGHT_MAP_DEEP_WATER, hash);
+    hash = mathutils::fnv1a_value(HEIGHT_MAP_WATER, hash);
+    hash = mathutils::fnv1a_value(HEIGHT_MAP_LOWLAND, hash);
+    hash = mathutils::fnv1a_value(HEIGHT_MAP_HIGHLAND, hash);
+    hash = mathutils::fnv1a_value(HEIGHT_MAP_MOUNTAIN, hash);
+    hash = mathutils::fnv1a_value(HEIGHT_MAP_MOUNTAIN_PEAK, hash);
+    return hash;
 }
 
-// Flood-fills an area starting at the coordinates, with the specified ID.
-void IslandProcGen::floodfill_sub_islands(Vector2u start, unsigned int id, DevCanvas* canvas_ptr)
-{
-    const uint32_t index = mathutils::array_index({start.x, start.y}, {size_, size_});
-    if (sub_island_id_.at(index) != SUB_ISLAND_ID_UNDEFINED) return;    // Do nothing if this tile has already been flood-filled.
-    if (height_map_.at(index) <= HEIGHT_MAP_WATER) return;  // Do nothing if this tile is water level or below.
+// Read-only access to the current generation parameters.
+const IslandParams& IslandProcGen::params() const { return params_; }
 
-    sub_island_id_.at(index) = id;  // Set the sub-island ID for this tile.
+// Read-only access to the settlements and dungeons placed on each sub-island, in sub-island order.
+const std::vector<PointOfInterest>& IslandProcGen::points_of_interest() const { return points_of_interest_; }
 
-    // If an existing sub_island_coords_ vector does not yet exist for this ID, make a new one.
-    if (sub_island_coords_.size() < id + 1)
+// Read-only access to the river markers for each tile (non-zero for rivers).
+const Grid2D<uint8_t>& IslandProcGen::river_map() const { return river_map_; }
+
+// Runs a single stage of the pipeline.
+void IslandProcGen::run_stage(Stage stage)
+{
+    const auto start_time = std::chrono::steady_clock::now();
+    switch(stage)
     {
-        std::vector<Vector2u> new_vec;
-        new_vec.push_back(start);
-        sub_island_coords_.push_back(new_vec);
+        case Stage::NOISE: stage_noise(); break;
+        case Stage::FALLOFF: stage_falloff(); break;
+        case Stage::BORDER: stage_border(); break;
+        case Stage::EROSION: stage_erosion(); break;
+        case Stage::DESPECKLE: stage_despeckle(); break;
+        case Stage::LABEL_SUB_ISLANDS: stage_label_sub_islands(); break;
+        case Stage::PRUNE_SUB_ISLANDS: stage_prune_sub_islands(); break;
+        case Stage::DISTANCE_FIELDS: stage_distance_fields(); break;
+        case Stage::RIVERS: stage_rivers(); break;
+        case Stage::POINTS_OF_INTEREST: stage_points_of_interest(); break;
     }
-    // Otherwise, just insert our current coordinates into the existing vector.
-    else sub_island_coords_.at(id).push_back(start);
+    const auto elapsed = std::chrono::steady_clock::now() - start_time;
+    stage_times_.at(static_cast<unsigned int>(stage)) = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+}
+
+// Derives a (non-zero) island seed from an RNG stream.
+uint32_t IslandProcGen::seed_from_rng(const RNG &rng) { return rng.split("island").get<uint32_t>(1, UINT32_MAX); }
+
+// The PRNG seed used to generate this island.
+uint32_t IslandProcGen::seed() const { return seed_; }
 
-    // If we're generating dev maps, now's a good time to draw the islands.
-    if (GENERATE_DEV_MAPS && canvas_ptr)
+// Changes the generation parameters, invalidating only the stages they affect. Call generate() afterwards to rerun them.
+void IslandProcGen::set_params(const IslandParams &params)
+{
+    if (params.perlin_octaves != params_.perlin_octaves || params.perlin_zoom != params_.perlin_zoom) invalidate(Stage::NOISE);
+    if (params.island_height_modifier != params_.island_height_modifier) invalidate(Stage::FALLOFF);
+    if (params.border_modifier_inner != params_.border_modifier_inner || params.border_modifier_outer != params_.border_modifier_outer)
+        invalidate(Stage::BORDER);
+    if (params.erosion_droplets != params_.erosion_droplets) invalidate(Stage::EROSION);
+    if (params.sub_island_min_size != params_.sub_island_min_size) invalidate(Stage::PRUNE_SUB_ISLANDS);
+    if (params.river_flow_min != params_.river_flow_min) invalidate(Stage::RIVERS);
+    if (params.settlement_spacing != params_.settlement_spacing || params.dungeon_spacing != params_.dungeon_spacing) invalidate(Stage::POINTS_OF_INTEREST);
+    params_ = params;
+}
+
+// The width and height of this island map.
+uint16_t IslandProcGen::size() const { return size_; }
+
+// BORDER: Ensures the map border is ocean, and lowers the next couple of tiles in. (falloff_map_ -> border_map_)
+void IslandProcGen::stage_border()
+{
+    border_map_ = falloff_map_;
+    for (unsigned int y = 0; y < size_; y++)
     {
-        Colour colour = Colour::WHITE;
-        switch(id)
+        float* row = border_map_.row_data(y);
+        for (unsigned int x = 0; x < size_; x++)
         {
-            case 0: colour = Colour::RED; break;
-            case 1: colour = Colour::ORANGE; break;
-            case 2: colour = Colour::YELLOW; break;
-            case 3: colour = Colour::GREEN; break;
-            case 4: colour = Colour::CYAN; break;
-            case 5: colour = Colour::BLUE; break;
-            case 6: colour = Colour::PURPLE; break;
-            case 7: colour = Colour::BROWN; break;
-            case 8: colour = Colour::RED_LIGHT; break;
-            case 9: colour = Colour::ORANGE_LIGHT; break;
-            case 10: colour = Colour::YELLOW_LIGHT; break;
-            case 11: colour = Colour::GREEN_LIGHT; break;
-            case 12: colour = Colour::CYAN_LIGHT; break;
-            case 13: colour = Colour::BLUE_LIGHT; break;
-            case 14: colour = Colour::PURPLE_LIGHT; break;
-            case 15: colour = Colour::BROWN_LIGHT; break;
-            case 16: colour = Colour::RED_DARK; break;
-            case 17: colour = Colour::ORANGE_DARK; break;
-            case 18: colour = Colour::YELLOW_DARK; break;
-            case 19: colour = Colour::GREEN_DARK; break;
-            case 20: colour = Colour::CYAN_DARK; break;
-            case 21: colour = Colour::BLUE_DARK; break;
-            case 22: colour = Colour::PURPLE_DARK; break;
-            case 23: colour = Colour::BROWN_DARK; break;
-            case 24: colour = Colour::GRAY; break;
+            if (!x || !y || x == size_ - 1u || y == size_ - 1u) row[x] = 0.0f;  // The outer border is always minimum-height.
+            else if (x == 1 || y == 1 || x == size_ - 2u || y == size_ - 2u) row[x] = std::min(row[x] - params_.border_modifier_outer, HEIGHT_MAP_WATER);
+            else if (x == 2 || y == 2 || x == size_ - 3u || y == size_ - 3u) row[x] = std::min(row[x] - params_.border_modifier_inner, HEIGHT_MAP_LOWLAND);
         }
-        canvas_ptr->put(Glyph::FULL_BLOCK, Vector2(start.x, start.y), colour);
     }
+}
 
-    // Check neighbouring tiles.
-    for (int x = -1; x <= 1; x++)
+// DESPECKLE: Removes solitary tiles stuck in the water. (eroded_map_ -> height_map_)
+void IslandProcGen::stage_despeckle()
+{
+    // This means: anything surrounded entirely by deep water becomes deep water, anything surrounded entirely by shallow water becomes shallow water.
+    // Anything that's already deeper than its neighbours is ignored. The map border is already ocean, so it's left as-is.
+    height_map_.resize(eroded_map_.size());
+    stencil::apply(eroded_map_.data(), height_map_.data(), height_map_.size(), [](float nw, float n, float ne, float w, float c, float e, float sw, float s,
+        float se)
     {
-        for (int y = -1; y <= 1; y++)
+        auto max2 = [](float a, float b) { return a < b ? b : a; };
+        const float highest_neighbour = max2(max2(max2(max2(nw, n), max2(ne, w)), max2(max2(e, sw), max2(s, se))), 0.0f);
+        if (c <= highest_neighbour) return c;
+        else if (highest_neighbour <= HEIGHT_MAP_DEEP_WATER) return HEIGHT_MAP_DEEP_WATER;
+        else if (highest_neighbour <= HEIGHT_MAP_WATER) return HEIGHT_MAP_WATER;
+        return c;
+    }, stencil::Border::COPY);
+}
+
+// DISTANCE_FIELDS: Measures the distance to the coast from every tile. (height_map_ -> distance_to_land_, distance_to_water_)
+void IslandProcGen::stage_distance_fields()
+{
+    distance_to_land_ = distancefield::distance_to(height_map_, [](float height) { return height > HEIGHT_MAP_WATER; });
+    distance_to_water_ = distancefield::distance_to(height_map_, [](float height) { return height <= HEIGHT_MAP_WATER; });
+}
+
+// EROSION: Carves the terrain with simulated rain droplets. (border_map_ -> eroded_map_)
+void IslandProcGen::stage_erosion()
+{
+    // The map is split into blocks, and droplets are confined to their own block, so every block in a pass can be eroded in parallel. Each block gets its
+    // own RNG stream, derived from the island seed, so the result is identical no matter how many threads there are or what order the blocks run in.
+    // Alternate passes shift the block grid by half a block, so that the block edges don't leave visible seams.
+    eroded_map_ = border_map_;
+    const uint32_t droplets_per_block = std::lround(params_.erosion_droplets * EROSION_BLOCK_SIZE * EROSION_BLOCK_SIZE / EROSION_PASSES);
+    if (!droplets_per_block) return;
+    const RNG erosion_rng = RNG(seed_).split("erosion");
+
+    for (uint32_t pass = 0; pass < EROSION_PASSES; pass++)
+    {
+        // The first row and column of blocks may be partial, when the grid is offset. Blocks never include the outer border of the map.
+        const uint32_t offset = (pass % 2 ? EROSION_BLOCK_SIZE / 2 : 0);
+        const uint32_t blocks_across = (size_ + offset + EROSION_BLOCK_SIZE - 1) / EROSION_BLOCK_SIZE;
+        const RNG pass_rng = erosion_rng.split(pass);
+        parallel::for_each(blocks_across * blocks_across, [this, offset, blocks_across, droplets_per_block, &pass_rng](uint32_t block)
         {
-            if (x == 0 && y == 0) continue; // Ignore current tile.
-            if (x && y) continue;   // Ignore diagonals.
-            if (static_cast<int>(start.x) + x < 0 || start.x + x >= size_) continue;
-            if (static_cast<int>(start.y) + y < 0 || start.y + y >= size_) continue;
-            floodfill_sub_islands(Vector2u(start.x + x, start.y + y), id, canvas_ptr);
-        }
+            auto block_edge = [this, offset](uint32_t b) { return std::clamp<int>(static_cast<int>(b * EROSION_BLOCK_SIZE) - offset, 1, size_ - 1); };
+            const uint32_t bx = block % blocks_across, by = block / blocks_across;
+            const Vector2u min(block_edge(bx), block_edge(by)), max(block_edge(bx + 1), block_edge(by + 1));
+            const uint32_t area = (max.x - min.x) * (max.y - min.y);
+            const uint32_t droplets = (static_cast<uint64_t>(droplets_per_block) * area) / (EROSION_BLOCK_SIZE * EROSION_BLOCK_SIZE);
+            erode_block(min, max, droplets, pass_rng.split(block));
+        });
     }
 }
 
-// Generates the heightmap of the island, based on Perlin noise followed by some other tweaks.
-void IslandProcGen::generate_heightmap()
+// FALLOFF: Lowers the land further from the centre of the map, providing a coastline. (noise_map_ -> falloff_map_)
+void IslandProcGen::stage_falloff()
 {
-    // First, we need to determine the height-map for the island. We'll do this with Perlin noise, then adjust it to allow for a coast.
-    height_map_.resize(size_ * size_);
-    const siv::PerlinNoise perlin{seed_};
-    for (unsigned int x = 0; x < size_; x++)
+    falloff_map_ = noise_map_;
+    const float centre = (size_ - 1) / 2.0f;
+    const float max_distance = std::sqrt(2) * centre;
+    for (unsigned int y = 0; y < size_; y++)
     {
-        for (unsigned int y = 0; y < size_; y++)
+        float* row = falloff_map_.row_data(y);
+        const float dy = y - centre;
+        for (unsigned int x = 0; x < size_; x++)
         {
-            const float noise = perlin.octave2D_01((x * PERLIN_ZOOM), (y * PERLIN_ZOOM), 4);
-            height_map_.at(mathutils::array_index({x, y}, {size_, size_})) = noise;
+            const float dx = x - centre;
+            const float distance = std::sqrt((dx * dx) + (dy * dy));
+            row[x] -= (distance / max_distance) * params_.island_height_modifier;
         }
     }
+}
 
-    // Adjust the height based on the distance from the centre of the map. Ideally, this can be tweaked to provide a coastline.
-    auto get_height_modifier = [this](unsigned int x, unsigned int y)
-    {
-        const float centre = (size_ - 1) / 2.0f;
-        const float dx = x - centre, dy = y - centre;
-        const float distance = std::sqrt((dx * dx) + (dy * dy));
-        const float max_distance = std::sqrt(2) * centre;
-        return (distance / max_distance) * ISLAND_HEIGHT_MODIFIER;
-    };
+// LABEL_SUB_ISLANDS: Labels each contiguous land-mass. (height_map_ -> sub_island_labels_, sub_island_label_coords_)
+void IslandProcGen::stage_label_sub_islands()
+{
+    sub_island_labels_.resize({size_, size_}, SUB_ISLAND_ID_UNDEFINED);
+    sub_island_label_coords_.clear();
+
+    // Flood-fill each land-mass in turn, with an explicit stack rather than recursion, so large islands can't overflow the call stack.
+    std::vector<Vector2u> fill_stack;
     for (unsigned int x = 0; x < size_; x++)
     {
         for (unsigned int y = 0; y < size_; y++)
         {
-            const uint32_t index = mathutils::array_index({x, y}, {size_, size_});
+            int &label = sub_island_labels_(x, y);
+            if (height_map_(x, y) <= HEIGHT_MAP_WATER)
+            {
+                label = SUB_ISLAND_ID_WATER;
+                continue;
+            }
+            else if (label != SUB_ISLAND_ID_UNDEFINED) continue;
 
-            // The further to the edges of the map you go, the lower the land drops.
-            height_map_.at(index) -= get_height_modifier(x, y);
+            const int id = sub_island_label_coords_.size();
+            sub_island_label_coords_.emplace_back();
+            std::vector<Vector2u> &coords = sub_island_label_coords_.back();
+            label = id;
+            fill_stack.push_back({x, y});
+            while (fill_stack.size())
+            {
+                const Vector2u pos = fill_stack.back();
+                fill_stack.pop_back();
+                coords.push_back(pos);
 
-            // We're also gonna ensure the map border is oceans, and the next couple of tiles in are similarly lowered.
-            if (!x || !y || x == size_ - 1u || y == size_ - 1u) height_map_.at(index) = 0.0f;   // The outer border is always minimum-height.
-            else if (x == 1 || y == 1 || x == size_ - 2u || y == size_ - 2u) height_map_.at(index) = std::min(height_map_.at(index) - BORDER_MODIFIER_OUTER,
-                HEIGHT_MAP_WATER);
-            else if (x == 2 || y == 2 || x == size_ - 3u || y == size_ - 3u) height_map_.at(index) = std::min(height_map_.at(index) - BORDER_MODIFIER_INNER,
-                HEIGHT_MAP_LOWLAND);
+                // Check neighbouring tiles, ignoring diagonals.
+                sub_island_labels_.for_each_neighbour(pos, GridNeighbours::ORTHOGONAL, [this, id, &fill_stack](uint32_t nx, uint32_t ny)
+                {
+                    int &neighbour_label = sub_island_labels_(nx, ny);
+                    if (neighbour_label != SUB_ISLAND_ID_UNDEFINED) return; // Already flood-filled.
+                    if (height_map_(nx, ny) <= HEIGHT_MAP_WATER) return;    // Water level or below.
+                    neighbour_label = id;
+                    fill_stack.push_back({nx, ny});
+                });
+            }
         }
     }
+}
+
+// NOISE: Generates the raw Perlin noise height map. (seed_ -> noise_map_)
+void IslandProcGen::stage_noise()
+{
+    noise_map_.resize({size_, size_});
+    const siv::PerlinNoise perlin{seed_};
+    for (unsigned int y = 0; y < size_; y++)
+    {
+        float* row = noise_map_.row_data(y);
+        for (unsigned int x = 0; x < size_; x++)
+            row[x] = perlin.octave2D_01((x * params_.perlin_zoom), (y * params_.perlin_zoom), params_.perlin_octaves);
+    }
+}
 
-    // Remove solitary tiles stuck in the water. This means: anything surrounded entirely by deep water becomes deep water, anything surrounded entirely by
-    // shallow water becomes shallow water. Anything that's already deeper than its neighbours is ignored.
-    for (unsigned int x = 1; x < size_ - 1u; x++)
+// POINTS_OF_INTEREST: Scatters settlements and dungeons across each sub-island. (height_map_, sub_island_id_, river_map_ -> points_of_interest_)
+void IslandProcGen::stage_points_of_interest()
+{
+    // Each sub-island is sampled separately, with its own RNG stream, so they can all run in parallel and the result is the same no matter how many
+    // threads there are. Settlements go down first, on dry ground below the highlands; dungeons then fill in the gaps, keeping their distance from the
+    // settlements as well as from each other.
+    const RNG poi_rng = RNG(seed_).split("poi");
+    std::vector<std::vector<PointOfInterest>> sub_island_pois(sub_island_coords_.size());
+    parallel::for_each(sub_island_coords_.size(), [this, &poi_rng, &sub_island_pois](uint32_t id)
     {
-        for (unsigned int y = 1; y < size_ - 1u; y++)
+        const std::vector<Vector2u> &coords = sub_island_coords_.at(id);
+        RNG rng = poi_rng.split(id);
+        Vector2u min = coords.at(0), max = coords.at(0);
+        for (auto pos : coords)
         {
-            const uint32_t index = mathutils::array_index({x, y}, {size_, size_});
-            const float current_level = height_map_.at(index);
-            float highest_neighbour = 0.0f;
+            min = {std::min(min.x, pos.x), std::min(min.y, pos.y)};
+            max = {std::max(max.x, pos.x), std::max(max.y, pos.y)};
+        }
+        max = max + Vector2u(1, 1);
+        auto random_seeds = [&coords, &rng]
+        {
+            std::vector<Vector2u> seeds;
+            for (uint32_t i = 0; i < POI_SEED_POINTS; i++)
+                seeds.push_back(coords.at(rng.get<size_t>(0, coords.size() - 1)));
+            return seeds;
+        };
 
-            for (int dx = -1; dx <= 1; dx++)
-            {
-                for (int dy = -1; dy <= 1; dy++)
-                {
-                    if (dx == 0 && dy == 0) continue;
-                    const float neighbour_tile = height_map_.at(mathutils::array_index(Vector2u(x + dx, y + dy), {size_, size_}));
-                    if (neighbour_tile > highest_neighbour) highest_neighbour = neighbour_tile;
-                }
-            }
+        auto dry_land = [this, id](uint32_t x, uint32_t y) { return sub_island_id_(x, y) == static_cast<int>(id) && !river_map_(x, y); };
+        const std::vector<Vector2u> settlements = poissondisc::sample(min, max, params_.settlement_spacing, rng, random_seeds(),
+            [this, &dry_land](uint32_t x, uint32_t y) { return dry_land(x, y) && height_map_(x, y) < HEIGHT_MAP_HIGHLAND; });
+        const std::vector<Vector2u> dungeons = poissondisc::sample(min, max, params_.dungeon_spacing, rng, random_seeds(), dry_land, settlements);
 
-            if (current_level <= highest_neighbour) continue;
-            else if (highest_neighbour <= HEIGHT_MAP_DEEP_WATER) height_map_.at(index) = HEIGHT_MAP_DEEP_WATER;
-            else if (highest_neighbour <= HEIGHT_MAP_WATER) height_map_.at(index) = HEIGHT_MAP_WATER;
-        }
+        std::vector<PointOfInterest> &pois = sub_island_pois.at(id);
+        for (auto pos : settlements)
+            pois.push_back({pos, static_cast<uint16_t>(id), PoiType::SETTLEMENT});
+        for (auto pos : dungeons)
+            pois.push_back({pos, static_cast<uint16_t>(id), PoiType::DUNGEON});
+    });
+
+    points_of_interest_.clear();
+    for (const auto &pois : sub_island_pois)
+        points_of_interest_.insert(points_of_interest_.end(), pois.begin(), pois.end());
+}
+
+// PRUNE_SUB_ISLANDS: Removes sub-islands that are too small. (sub_island_labels_ -> sub_island_id_, sub_island_coords_)
+void IslandProcGen::stage_prune_sub_islands()
+{
+    // Build a table mapping each labelled land-mass to its final ID, so that the remaining sub-islands keep their relative order.
+    std::vector<int> remap(sub_island_label_coords_.size(), SUB_ISLAND_ID_TOO_SMALL);
+    sub_island_coords_.clear();
+    for (unsigned int i = 0; i < sub_island_label_coords_.size(); i++)
+    {
+        if (sub_island_label_coords_.at(i).size() < params_.sub_island_min_size) continue;
+        remap.at(i) = sub_island_coords_.size();
+        sub_island_coords_.push_back(sub_island_label_coords_.at(i));
     }
 
-    // If we're generating dev maps, at this point we'll draw the final result.
-    if (GENERATE_DEV_MAPS)
+    sub_island_id_ = sub_island_labels_;
+    int* ids = sub_island_id_.data();
+    for (size_t i = 0; i < sub_island_id_.storage_size(); i++)
+        if (ids[i] >= 0) ids[i] = remap[ids[i]];
+}
+
+// RIVERS: Routes rainfall downhill to the sea, and marks rivers. (height_map_, sub_island_id_ -> flow_map_, river_map_)
+void IslandProcGen::stage_rivers()
+{
+    // This is a priority-flood: starting from every water tile, we flood uphill, always expanding from the lowest tile reached so far. Each tile drains
+    // into the tile it was reached from, which gives every land tile a route to the sea, even from inside depressions (which are effectively filled to
+    // their spill point, as the queue never goes back down).
+    const uint32_t tiles = size_ * size_;
+    const float* heights = height_map_.data();
+    const auto [lowest, highest] = std::minmax_element(heights, heights + tiles);
+    const float bucket_scale = (*highest > *lowest ? (RIVER_HEIGHT_BUCKETS - 1) / (*highest - *lowest) : 0.0f);
+    const float bucket_base = *lowest;
+    auto bucket = [bucket_scale, bucket_base](float height) { return static_cast<uint32_t>((height - bucket_base) * bucket_scale); };
+
+    std::vector<uint32_t> receiver(tiles, BucketQueue::NONE);   // The tile each tile drains into.
+    std::vector<uint32_t> flood_order;  // Every tile, in the order it was flooded, from the sea upwards.
+    std::vector<uint8_t> visited(tiles, 0);
+    flood_order.reserve(tiles);
+    BucketQueue queue(RIVER_HEIGHT_BUCKETS, tiles);
+    for (uint32_t i = 0; i < tiles; i++)
     {
-        uint32_t canvas_id = game().add_element(std::make_unique<DevCanvas>(Vector2u(size_, size_)));
-        DevCanvas& canvas_ref = static_cast<DevCanvas&>(game().element(canvas_id));
-        for (unsigned int x = 0; x < size_; x++)
+        if (heights[i] > HEIGHT_MAP_WATER) continue;
+        visited[i] = 1;
+        queue.push(i, bucket(heights[i]));
+    }
+    while (!queue.empty())
+    {
+        const uint32_t index = queue.pop();
+        flood_order.push_back(index);
+        height_map_.for_each_neighbour({index % size_, index / size_}, GridNeighbours::ORTHOGONAL,
+            [this, index, heights, &bucket, &queue, &receiver, &visited](uint32_t nx, uint32_t ny)
         {
-            for (unsigned int y = 0; y < size_; y++)
-            {
-                const float noise = height_map_.at(mathutils::array_index({x, y}, {size_, size_}));
-                Colour col = Colour::GREEN;
-                if (noise <= HEIGHT_MAP_DEEP_WATER) col = Colour::BLUE_DARK;
-                else if (noise <= HEIGHT_MAP_WATER) col = Colour::BLUE;
-                else if (noise <= HEIGHT_MAP_LOWLAND) col = Colour::GREEN_LIGHT;
-                else if (noise >= HEIGHT_MAP_MOUNTAIN_PEAK) col = Colour::WHITE;
-                else if (noise >= HEIGHT_MAP_MOUNTAIN) col = Colour::GRAY;
-                else if (noise >= HEIGHT_MAP_HIGHLAND) col = Colour::GREEN_DARK;
-                canvas_ref.put(Glyph::FULL_BLOCK, Vector2(x, y), col);
-            }
-        }
+            const uint32_t neighbour = height_map_.index(nx, ny);
+            if (visited[neighbour]) return;
+            visited[neighbour] = 1;
+            receiver[neighbour] = index;
+            queue.push(neighbour, bucket(heights[neighbour]));
+        });
     }
+
+    // Flow accumulation: each land tile contributes one tile's worth of rainfall, which is passed downstream in reverse flood order, so every tile is
+    // finished before the tile it drains into.
+    flow_map_.resize({size_, size_}, 0);
+    uint32_t* flow = flow_map_.data();
+    for (uint32_t i = 0; i < tiles; i++)
+        if (heights[i] > HEIGHT_MAP_WATER) flow[i] = 1;
+    for (auto it = flood_order.rbegin(); it != flood_order.rend(); ++it)
+        if (receiver[*it] != BucketQueue::NONE) flow[receiver[*it]] += flow[*it];
+
+    // Rivers only run across land that belongs to a sub-island; scraps of land too small to count don't get any.
+    river_map_.resize({size_, size_}, 0);
+    uint8_t* rivers = river_map_.data();
+    const int* sub_island_ids = sub_island_id_.data();
+    for (uint32_t i = 0; i < tiles; i++)
+        if (heights[i] > HEIGHT_MAP_WATER && sub_island_ids[i] >= 0 && flow[i] >= params_.river_flow_min) rivers[i] = 1;
+}
+
+// Returns the human-readable name of a generation stage.
+std::string IslandProcGen::stage_name(Stage stage)
+{
+    switch(stage)
+    {
+        case Stage::NOISE: return "noise";
+        case Stage::FALLOFF: return "falloff";
+        case Stage::BORDER: return "border";
+        case Stage::EROSION: return "erosion";
+        case Stage::DESPECKLE: return "despeckle";
+        case Stage::LABEL_SUB_ISLANDS: return "label";
+        case Stage::PRUNE_SUB_ISLANDS: return "prune";
+        case Stage::DISTANCE_FIELDS: return "distance";
+        case Stage::RIVERS: return "rivers";
+        case Stage::POINTS_OF_INTEREST: return "poi";
+    }
+    return "unknown";
+}
+
+// The wall time taken by a stage the last time it ran, in microseconds.
+uint64_t IslandProcGen::stage_time(Stage stage) const { return stage_times_.at(static_cast<unsigned int>(stage)); }
+
+// Read-only access to the coordinates of each sub-island.
+const std::vector<std::vector<Vector2u>>& IslandProcGen::sub_island_coords() const { return sub_island_coords_; }
+
+// Read-only access to the sub-island ID markers for each tile.
+const Grid2D<int>& IslandProcGen::sub_island_ids() const { return sub_island_id_; }
+
+// Returns a one-line summary of each stage's wall time, for logging.
+std::string IslandProcGen::timing_report() const
+{
+    std::string report = "Island " + std::to_string(size_) + "x" + std::to_string(size_) + " stage times (us):";
+    for (unsigned int i = 0; i < STAGE_COUNT; i++)
+        report += " " + stage_name(static_cast<Stage>(i)) + "=" + std::to_string(stage_times_.at(i));
+    return report;
 }
 
 }   // namespace gorp
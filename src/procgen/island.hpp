@@ -6,34 +6,39 @@
 
 #pragma once
 
+#include <array>
+
 #include "core/global.hpp"
+#include "util/math/grid2d.hpp"
+#include "procgen/point-of-interest.hpp"
 
 namespace gorp {
 
-class DevCanvas;    // defined ui/dev-canvas.hpp
+class RNG;  // defined in util/math/rng.hpp
+
+// The tunable parameters for island generation. Changing these with IslandProcGen::set_params() only reruns the stages they affect.
+struct IslandParams
+{
+    float       border_modifier_inner =     0.1f;   // The fixed reduction in height for the inner border of the map.
+    float       border_modifier_outer =     0.2f;   // As above, but for the outer border.
+    // The minimum distance in tiles between dungeons, and between a dungeon and a settlement. 0 disables dungeons.
+    float       dungeon_spacing =           12.0f;
+    float       erosion_droplets =          1.0f;   // Hydraulic erosion droplets simulated per tile. Higher is smoother but slower; 0 disables erosion.
+    float       island_height_modifier =    0.6f;   // The distance-from-centre modifier that adjusts the island height, providing a coastline.
+    int         perlin_octaves =            4;      // The number of Perlin noise octaves.
+    float       perlin_zoom =               0.1f;   // The Perlin noise zoom level.
+    unsigned int    river_flow_min =        50;     // The number of tiles that must drain through a land tile for it to become a river.
+    float       settlement_spacing =        20.0f;  // The minimum distance in tiles between settlements. 0 disables settlements.
+    unsigned int    sub_island_min_size =   30;     // The minimum size for a sub-island to count.
+};
 
 class IslandProcGen {
 public:
-    IslandProcGen() = delete;   // No default constructor.
-    IslandProcGen(uint16_t size, unsigned int seed = 0);    // Generates a new island of the specified size, with an optional PRNG seed.
-
-private:
-    void    determine_sub_islands();        // Determines which land-masses are contiguous, and defines these as sub-islands.
-    void    erase_sub_island(unsigned int id, DevCanvas* canvas_ptr);   // Erases a specified sub-island, reassigning other IDs.
-    void    floodfill_sub_islands(Vector2u start, unsigned int id, DevCanvas* canvas_ptr);  // Flood-fills an area starting at the coords with the specified ID.
-    void    generate_heightmap();           // Generates the heightmap of the island, based on Perlin noise followed by some other tweaks.
-
-    static constexpr bool       GENERATE_DEV_MAPS =         true;   // Used for visual feedback during development/debugging/testing.
-
-    static constexpr uint16_t   ISLAND_SIZE_MAX =           512;    // The largest allowed island size.
-    static constexpr uint16_t   ISLAND_SIZE_MIN =           16;     // The smallest sllowed island size.
-
-    static constexpr float      BORDER_MODIFIER_INNER =     0.1f;   // The fixed reduction in height for the inner border of the map.
-    static constexpr float      BORDER_MODIFIER_OUTER =     0.2f;   // As above, but for the outer border.
-    static constexpr float      ISLAND_HEIGHT_MODIFIER =    0.6f;   // The distance-from-centre modifier that adjusts the island height, providing a coatline.
+    // The stages of the generation pipeline, in the order they run. Each stage reads only the output of the stages before it.
+    enum class Stage : uint8_t { NOISE, FALLOFF, BORDER, EROSION, DESPECKLE, LABEL_SUB_ISLANDS, PRUNE_SUB_ISLANDS, DISTANCE_FIELDS, RIVERS,
+        POINTS_OF_INTEREST };
 
-    static constexpr float      PERLIN_OCTAVES =            4;      // The number of Perlin noise octaves.
-    static constexpr float      PERLIN_ZOOM =               0.1f;   // The Perlin noise zoom level.
+    static constexpr unsigned int   STAGE_COUNT =   10; // The number of stages in the Stage enum.
 
     static constexpr float      HEIGHT_MAP_DEEP_WATER =     0.1f;   // Any tile heights at this point or below are deep water.
     static constexpr float      HEIGHT_MAP_WATER =          0.2f;   // As above, but for regular water.
@@ -46,13 +51,98 @@ private:
     static constexpr int        SUB_ISLAND_ID_WATER =       -2;     // This tile is water, and cannot belong to a sub-island.
     static constexpr int        SUB_ISLAND_ID_TOO_SMALL =   -3;     // The ID for tiles that were part of a sub-island considered too small to count.
 
-    static constexpr int        SUB_ISLAND_MIN_SIZE =       30;     // The minimum size for a sub-island to count.
+    static constexpr uint32_t   RIVER_HEIGHT_BUCKETS =      4096;   // The number of height buckets used when routing water downhill.
 
-    std::vector<float>  height_map_;    // The height map of the island, which determines the terrain.
+    // The number of random tiles on each sub-island that point-of-interest sampling starts from.
+    static constexpr uint32_t   POI_SEED_POINTS =           8;
+
+    static constexpr uint32_t   EROSION_BLOCK_SIZE =        32;     // Erosion runs in parallel over square blocks of this many tiles.
+    static constexpr uint32_t   EROSION_PASSES =            4;      // Erosion is split into passes, alternating the block grid offset to hide seams.
+    static constexpr int        EROSION_DROPLET_LIFETIME =  30;     // The maximum number of steps a droplet takes before evaporating.
+    static constexpr float      EROSION_INERTIA =           0.05f;  // How much a droplet keeps its previous direction, rather than following the slope.
+    static constexpr float      EROSION_CAPACITY =          0.5f;   // Multiplier for how much sediment a droplet can carry.
+    static constexpr float      EROSION_MIN_SLOPE =         0.01f;  // The minimum slope used for sediment capacity, so flat ground still erodes.
+    static constexpr float      EROSION_DEPOSIT_RATE =      0.3f;   // The fraction of excess sediment deposited per step.
+    static constexpr float      EROSION_ERODE_RATE =        0.05f;  // The fraction of spare capacity filled by eroding the ground per step.
+    static constexpr float      EROSION_EVAPORATION =       0.01f;  // The fraction of a droplet's water lost per step.
+    static constexpr float      EROSION_GRAVITY =           4.0f;   // How quickly droplets speed up going downhill.
+
+    static constexpr uint16_t   ISLAND_SIZE_MAX =           512;    // The largest allowed island size.
+    static constexpr uint16_t   ISLAND_SIZE_MIN =           16;     // The smallest sllowed island size.
+
+    // Increase this whenever the generation algorithm changes in a way that changes its output, so that old cached islands are discarded.
+    static constexpr uint32_t   ISLAND_GENERATOR_VERSION =  5;
+
+    IslandProcGen() = delete;   // No default constructor.
+    // Generates a new island of the specified size, with an optional PRNG seed and generation parameters.
+    IslandProcGen(uint16_t size, unsigned int seed = 0, const IslandParams &params = IslandParams());
+    // Generates a new island of the specified size, taking its seed from the "island" stream of the given RNG.
+    IslandProcGen(uint16_t size, const RNG &rng, const IslandParams &params = IslandParams());
+    // Read-only access to the Euclidean distance from each tile to the nearest land tile (0 on land).
+    const Grid2D<float>&        distance_to_land() const;
+    // Read-only access to the Euclidean distance from each tile to the nearest water tile (0 on water).
+    const Grid2D<float>&        distance_to_water() const;
+    // Read-only access to the flow accumulation map: the number of land tiles (including itself) that drain through each tile.
+    const Grid2D<uint32_t>&     flow_map() const;
+    void                        generate();             // Runs any stages that have been invalidated since the last generation.
+    const Grid2D<float>&        height_map() const;     // Read-only access to the generated height map.
+    const IslandParams&         params() const;         // Read-only access to the current generation parameters.
+    // A hash of every parameter that affects the generated output, used to key cached islands.
+    static uint64_t             parameter_hash(const IslandParams &params = IslandParams());
+    // Read-only access to the settlements and dungeons placed on each sub-island, in sub-island order.
+    const std::vector<PointOfInterest>& points_of_interest() const;
+    const Grid2D<uint8_t>&      river_map() const;      // Read-only access to the river markers for each tile (non-zero for rivers).
+    uint32_t                    seed() const;           // The PRNG seed used to generate this island.
+    void                        set_params(const IslandParams &params); // Changes the generation parameters, invalidating only the stages they affect.
+    uint16_t                    size() const;           // The width and height of this island map.
+    static std::string          stage_name(Stage stage);    // Returns the human-readable name of a generation stage.
+    uint64_t                    stage_time(Stage stage) const;  // The wall time taken by a stage the last time it ran, in microseconds.
+    const std::vector<std::vector<Vector2u>>&   sub_island_coords() const;  // Read-only access to the coordinates of each sub-island.
+    const Grid2D<int>&          sub_island_ids() const; // Read-only access to the sub-island ID markers for each tile.
+    std::string                 timing_report() const;  // Returns a one-line summary of each stage's wall time, for logging.
+
+private:
+    // Simulates erosion droplets within a single block of eroded_map_. Droplets never leave the block, so separate blocks can run in parallel.
+    void    erode_block(Vector2u min, Vector2u max, uint32_t droplets, RNG rng);
+    void    invalidate(Stage stage);    // Marks a stage, and every stage after it, as needing to be rerun.
+    void    run_stage(Stage stage);     // Runs a single stage of the pipeline.
+    static uint32_t seed_from_rng(const RNG &rng);  // Derives a (non-zero) island seed from an RNG stream.
+    void    stage_border();             // BORDER: Ensures the map border is ocean, and lowers the next couple of tiles in. (falloff_map_ -> border_map_)
+    void    stage_despeckle();          // DESPECKLE: Removes solitary tiles stuck in the water. (eroded_map_ -> height_map_)
+    // DISTANCE_FIELDS: Measures the distance to the coast from every tile. (height_map_ -> distance_to_land_, distance_to_water_)
+    void    stage_distance_fields();
+    void    stage_erosion();            // EROSION: Carves the terrain with simulated rain droplets. (border_map_ -> eroded_map_)
+    void    stage_falloff();            // FALLOFF: Lowers the land further from the centre of the map, providing a coastline. (noise_map_ -> falloff_map_)
+    // LABEL_SUB_ISLANDS: Labels each contiguous land-mass. (height_map_ -> sub_island_labels_, sub_island_label_coords_)
+    void    stage_label_sub_islands();
+    void    stage_noise();              // NOISE: Generates the raw Perlin noise height map. (seed_ -> noise_map_)
+    // POINTS_OF_INTEREST: Scatters settlements and dungeons across each sub-island. (height_map_, sub_island_id_, river_map_ -> points_of_interest_)
+    void    stage_points_of_interest();
+    // PRUNE_SUB_ISLANDS: Removes sub-islands that are too small. (sub_island_labels_ -> sub_island_id_, sub_island_coords_)
+    void    stage_prune_sub_islands();
+    // RIVERS: Routes rainfall downhill to the sea, and marks rivers. (height_map_, sub_island_id_ -> flow_map_, river_map_)
+    void    stage_rivers();
+
+    Grid2D<float>       border_map_;    // Output of the BORDER stage.
+    Grid2D<float>       distance_to_land_;  // Distance from each tile to the nearest land tile. Output of DISTANCE_FIELDS.
+    Grid2D<float>       distance_to_water_; // Distance from each tile to the nearest water tile. Output of DISTANCE_FIELDS.
+    Grid2D<float>       eroded_map_;    // Output of the EROSION stage.
+    Grid2D<float>       falloff_map_;   // Output of the FALLOFF stage.
+    unsigned int        first_dirty_;   // The first stage that needs to be rerun, or STAGE_COUNT if everything is up to date.
+    Grid2D<uint32_t>    flow_map_;      // The number of land tiles draining through each tile. Output of RIVERS.
+    Grid2D<float>       height_map_;    // The height map of the island, which determines the terrain. Output of the DESPECKLE stage.
+    Grid2D<float>       noise_map_;     // Output of the NOISE stage.
+    IslandParams        params_;        // The current generation parameters.
+    std::vector<PointOfInterest>    points_of_interest_;    // Settlements and dungeons on each sub-island. Output of POINTS_OF_INTEREST.
+    Grid2D<uint8_t>     river_map_;     // Non-zero for river tiles. Output of RIVERS.
     uint32_t    seed_;          // The PRNG seed, used to (hopefully) generate identical islands with the same seed.
     uint16_t    size_;          // The size of this island map. Limited to uint16_t because any larger would just be ridiculous.
+    std::array<uint64_t, STAGE_COUNT>   stage_times_;   // The wall time taken by each stage the last time it ran, in microseconds.
     std::vector<std::vector<Vector2u>>  sub_island_coords_; // Coordinates for each sub-island on the generated map.
-    std::vector<int>    sub_island_id_; // Sub-island ID markers for each coordinate on the map.
+    Grid2D<int>         sub_island_id_; // Sub-island ID markers for each coordinate on the map.
+    // Coordinates for each labelled land-mass, before pruning. Output of LABEL_SUB_ISLANDS.
+    std::vector<std::vector<Vector2u>>  sub_island_label_coords_;
+    Grid2D<int>         sub_island_labels_; // Land-mass labels for each tile, before pruning. Output of LABEL_SUB_ISLANDS.
 };
 
 }   // namespace gorp
@@ -0,0 +1,24 @@
+// procgen/point-of-interest.hpp -- The settlements and dungeons scattered across each island during generation.
+
+// SPDX-FileType: SOURCE
+// SPDX-FileCopyrightText: Copyright 2025 Raine Simmons <gc@gravecat.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include "core/global.hpp"
+
+namespace gorp {
+
+// The kinds of point of interest scattered across each island's regions.
+enum class PoiType : uint8_t { SETTLEMENT, DUNGEON };
+
+// A single point of interest placed during island generation.
+struct PointOfInterest
+{
+    Vector2u    pos;        // The tile this point of interest sits on.
+    uint16_t    region;     // The region (sub-island) ID it belongs to.
+    PoiType     type;       // What kind of point of interest this is.
+};
+
+}   // namespace gorp
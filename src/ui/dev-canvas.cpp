@@ -19,6 +19,9 @@ DevCanvas::DevCanvas(Vector2u size) : Element(), size_(size)
     recreate_window();
 }
 
+// Draws a full canvas-sized grid of solid-colour tiles in one pass.
+void DevCanvas::blit(const std::vector<Colour> &cells, Vector2 pos) { window_->blit(cells, size_, pos); needs_redraw(); }
+
 // Clears the canvas entirely.
 void DevCanvas::clear(Colour col) { window_->clear(col); needs_redraw(); }
 
@@ -18,6 +18,7 @@ public:
             DevCanvas() = delete;       // No default constructor; must specify window size.
             DevCanvas(bool) = delete;   // Bool constructor from Element is also deleted.
             DevCanvas(Vector2u size);   // Creates a new DevCanvas of the specified size, in tiles.
+    void    blit(const std::vector<Colour> &cells, Vector2 pos = {0, 0});  // Draws a full canvas-sized grid of solid-colour tiles in one pass.
     void    clear(Colour col = Colour::BLACK);  // Clears the canvas entirely.
     void    print(std::string str, Vector2 pos, Colour colour = Colour::WHITE, Font font = Font::NORMAL);   // Prints a string.
     bool    process_input(int key) override;    // Processes keyboard input from the player.
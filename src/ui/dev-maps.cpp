@@ -0,0 +1,101 @@
+// ui/dev-maps.cpp -- Development-only visualisers, which turn generated data (such as procgen islands) into DevCanvas previews.
+// These are kept entirely separate from the generation code, so that generation itself only ever produces pure data.
+
+// SPDX-FileType: SOURCE
+// SPDX-FileCopyrightText: Copyright 2025 Raine Simmons <gc@gravecat.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "core/game.hpp"
+#include "ui/dev-canvas.hpp"
+#include "ui/dev-maps.hpp"
+#include "world/island-data.hpp"
+#include "world/terrain-pyramid.hpp"
+
+namespace gorp {
+namespace devmaps {
+
+// Creates a new DevCanvas of the specified size, and returns a reference to it.
+static DevCanvas& new_canvas(uint16_t size)
+{
+    const uint32_t canvas_id = game().add_element(std::make_unique<DevCanvas>(Vector2u(size, size)));
+    return static_cast<DevCanvas&>(game().element(canvas_id));
+}
+
+// Picks the colour used to draw each terrain class.
+static Colour terrain_colour(Terrain terrain)
+{
+    switch(terrain)
+    {
+        case Terrain::DEEP_WATER: return Colour::BLUE_DARK;
+        case Terrain::WATER: return Colour::BLUE;
+        case Terrain::LOWLAND: return Colour::GREEN_LIGHT;
+        case Terrain::LAND: return Colour::GREEN;
+        case Terrain::HIGHLAND: return Colour::GREEN_DARK;
+        case Terrain::MOUNTAIN: return Colour::GRAY;
+        case Terrain::PEAK: return Colour::WHITE;
+    }
+    return Colour::GREEN;
+}
+
+// Renders an island's terrain classes onto a new DevCanvas.
+void show_heightmap(const IslandData &island)
+{
+    const IslandGridView<uint8_t> terrain = island.terrain_map();
+    const uint16_t size = island.size();
+    std::vector<Colour> cells(size * size);
+    for (unsigned int y = 0; y < size; y++)
+    {
+        const uint8_t *row = terrain.row(y);
+        for (unsigned int x = 0; x < size; x++)
+        {
+            Colour col = terrain_colour(static_cast<Terrain>(row[x] & IslandData::TERRAIN_CLASS_MASK));
+            if (row[x] & IslandData::TERRAIN_FLAG_RIVER) col = Colour::CYAN;
+            cells[(y * size) + x] = col;
+        }
+    }
+    for (const auto &poi : island.points_of_interest())
+        cells[(poi.pos.y * size) + poi.pos.x] = (poi.type == PoiType::SETTLEMENT ? Colour::YELLOW : Colour::RED);
+    new_canvas(size).blit(cells);
+}
+
+// Renders a zoomed-out overview of an island onto a new DevCanvas, no more than max_size cells across.
+void show_overview(const IslandData &island, uint16_t max_size)
+{
+    // Only the pyramid level that fits is read, so the cost depends on the size of the overview, not the size of the island.
+    const TerrainPyramid &pyramid = island.pyramid();
+    const unsigned int level = pyramid.level_for_size(max_size);
+    const uint16_t size = pyramid.level_size(level);
+    std::vector<Colour> cells(size * size);
+    for (unsigned int y = 0; y < size; y++)
+        for (unsigned int x = 0; x < size; x++)
+            cells[(y * size) + x] = terrain_colour(pyramid.cell(level, x, y).dominant);
+    new_canvas(size).blit(cells);
+}
+
+// Renders an island's sub-island regions onto a new DevCanvas.
+void show_sub_islands(const IslandData &island)
+{
+    // Each sub-island gets its own colour, cycling through the palette if there are more sub-islands than colours.
+    static const Colour palette[] = { Colour::RED, Colour::ORANGE, Colour::YELLOW, Colour::GREEN, Colour::CYAN, Colour::BLUE, Colour::PURPLE, Colour::BROWN,
+        Colour::RED_LIGHT, Colour::ORANGE_LIGHT, Colour::YELLOW_LIGHT, Colour::GREEN_LIGHT, Colour::CYAN_LIGHT, Colour::BLUE_LIGHT, Colour::PURPLE_LIGHT,
+        Colour::BROWN_LIGHT, Colour::RED_DARK, Colour::ORANGE_DARK, Colour::YELLOW_DARK, Colour::GREEN_DARK, Colour::CYAN_DARK, Colour::BLUE_DARK,
+        Colour::PURPLE_DARK, Colour::BROWN_DARK, Colour::GRAY };
+    constexpr unsigned int palette_size = sizeof(palette) / sizeof(palette[0]);
+
+    const IslandGridView<uint16_t> regions = island.regions();
+    const uint16_t size = island.size();
+    std::vector<Colour> cells(size * size, Colour::BLACK);
+    for (unsigned int y = 0; y < size; y++)
+    {
+        const uint16_t *row = regions.row(y);
+        for (unsigned int x = 0; x < size; x++)
+        {
+            const uint16_t id = row[x];
+            if (id <= IslandData::REGION_MAX) cells[(y * size) + x] = palette[id % palette_size];
+            else if (id == IslandData::REGION_TOO_SMALL) cells[(y * size) + x] = Colour::GRAY_DARK;
+        }
+    }
+    new_canvas(size).blit(cells);
+}
+
+} } // namespace devmaps, gorp
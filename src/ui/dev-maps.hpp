@@ -0,0 +1,23 @@
+// ui/dev-maps.hpp -- Development-only visualisers, which turn generated data (such as procgen islands) into DevCanvas previews.
+// These are kept entirely separate from the generation code, so that generation itself only ever produces pure data.
+
+// SPDX-FileType: SOURCE
+// SPDX-FileCopyrightText: Copyright 2025 Raine Simmons <gc@gravecat.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include "core/global.hpp"
+
+namespace gorp {
+
+class IslandData;   // defined in world/island-data.hpp
+
+namespace devmaps {
+
+void    show_heightmap(const IslandData &island);   // Renders an island's terrain classes onto a new DevCanvas.
+// Renders a zoomed-out overview of an island onto a new DevCanvas, no more than max_size cells across.
+void    show_overview(const IslandData &island, uint16_t max_size);
+void    show_sub_islands(const IslandData &island); // Renders an island's sub-island regions onto a new DevCanvas.
+
+} } // namespace devmaps, gorp
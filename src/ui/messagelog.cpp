@@ -16,6 +16,9 @@ namespace gorp {
 // Constructor, sets things up.
 MessageLog::MessageLog() { recreate_window(); }
 
+// The unformatted lines in the message log, oldest first.
+const std::vector<std::string>& MessageLog::lines() const { return log_unprocessed_; }
+
 // Adds a string to the message log.
 void MessageLog::message(const std::string &msg)
 {
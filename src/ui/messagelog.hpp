@@ -14,6 +14,7 @@ namespace gorp {
 class MessageLog : public Element {
 public:
             MessageLog();   // Constructor, sets up the message log window.
+    const std::vector<std::string>& lines() const;  // The unformatted lines in the message log, oldest first.
     void    message(const std::string &str);    // Adds a string to the message log.
     bool    process_input(int key) override;    // Processes keyboard input from the player.
     void    recreate_window() override;         // (Re)creates the render window.
@@ -10,25 +10,23 @@
 #include "core/terminal/terminal.hpp"
 #include "core/terminal/window.hpp"
 #include "ui/title.hpp"
-#include "util/file/fileutils.hpp"
-#include "util/file/yaml.hpp"
+#include "util/file/datapack.hpp"
 #include "util/math/random.hpp"
+#include "world/codex.hpp"
 
 namespace gorp {
 
 // Simple constructor, sets things up.
 TitleScreen::TitleScreen() : blinking_(false), title_screen_window_(nullptr)
 {
-    YAML title_data(core().datafile("misc/title.yml"));
-    if (!title_data.is_map()) throw GuruMeditation("misc/title/yml: Invalid file format");
-
-    // Load the backronym and random phrase for the title screen.
-    std::vector<std::string> g_words = title_data.get_seq("g_words");
-    std::vector<std::string> r_words = title_data.get_seq("r_words");
-    std::vector<std::string> p_words = title_data.get_seq("p_words");
-    std::vector<std::string> phrases = title_data.get_seq("phrases");
-    backronym_ = g_words.at(random::get<int>(0, g_words.size() - 1)) + " of " + r_words.at(random::get<int>(0, r_words.size() - 1)) + " " +
-        p_words.at(random::get<int>(0, p_words.size() - 1));
+    // Pick the backronym and random phrase for the title screen, straight from the data pack.
+    const DataPack &data = codex().data();
+    const DataPack::StringList g_words = data.list("misc/title/g_words");
+    const DataPack::StringList r_words = data.list("misc/title/r_words");
+    const DataPack::StringList p_words = data.list("misc/title/p_words");
+    const DataPack::StringList phrases = data.list("misc/title/phrases");
+    backronym_ = std::string(g_words.at(random::get<int>(0, g_words.size() - 1))) + " of " +
+        std::string(r_words.at(random::get<int>(0, r_words.size() - 1))) + " " + std::string(p_words.at(random::get<int>(0, p_words.size() - 1)));
     phrase_ = phrases.at(random::get<int>(0, phrases.size() - 1));
 }
 
@@ -0,0 +1,151 @@
+// util/file/archive.cpp -- Single-file archives of game data, with a sorted index, memory-mapped so that reading a file never touches the filesystem.
+
+// SPDX-FileType: SOURCE
+// SPDX-FileCopyrightText: Copyright 2025 Raine Simmons <gc@gravecat.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <algorithm>
+#include <cstring>  // std::memcmp, std::memcpy
+
+#include "util/file/archive.hpp"
+#include "util/file/binpath.hpp"
+#include "util/file/fileutils.hpp"
+#include "util/file/mappedfile.hpp"
+#include "util/math/mathutils.hpp"
+
+namespace gorp {
+
+// The archive file layout is a fixed 32-byte header, followed by the index, then the path table, and finally the contents of every file, each one aligned
+// to BLOB_ALIGNMENT bytes. Only the index and path table are covered by the checksum, so opening an archive never has to read the files themselves.
+// Every value is little-endian, as in every other binary file. The index is read in place, so each field is passed through fileutils::little_endian()
+// as it's read.
+//
+//  0   char[4]     "GPAK" magic
+//  4   uint32_t    ARCHIVE_VERSION
+//  8   uint32_t    entry count
+//  12  uint32_t    path table size
+//  16  uint64_t    FNV-1a checksum of the index and path table
+//  24  uint64_t    total file size
+
+// Maps an archive file (relative to the game's path), and checks its index. Throws on failure.
+Archive::Archive(const std::string &filename) : entry_count_(0), entries_(nullptr), mapping_(nullptr), paths_(nullptr)
+{
+    const std::string full_path = BinPath::game_path(filename);
+    if (!fileutils::file_exists(full_path)) throw GuruMeditation("Archive not found: " + filename);
+    mapping_ = std::make_unique<const MappedFile>(full_path);
+    const char* data = mapping_->data();
+    const size_t size = mapping_->size();
+    if (size < HEADER_SIZE || std::memcmp(data, "GPAK", 4)) throw GuruMeditation("Invalid archive: " + filename);
+
+    uint32_t version, paths_size;
+    uint64_t checksum, total_size;
+    std::memcpy(&version, data + 4, sizeof(uint32_t));
+    std::memcpy(&entry_count_, data + 8, sizeof(uint32_t));
+    std::memcpy(&paths_size, data + 12, sizeof(uint32_t));
+    std::memcpy(&checksum, data + 16, sizeof(uint64_t));
+    std::memcpy(&total_size, data + 24, sizeof(uint64_t));
+    version = fileutils::little_endian(version);
+    entry_count_ = fileutils::little_endian(entry_count_);
+    paths_size = fileutils::little_endian(paths_size);
+    checksum = fileutils::little_endian(checksum);
+    total_size = fileutils::little_endian(total_size);
+    if (version != ARCHIVE_VERSION) throw GuruMeditation("Archive version mismatch: " + filename, version, ARCHIVE_VERSION);
+    if (total_size != size) throw GuruMeditation("Archive is truncated: " + filename);
+    const uint64_t index_size = (static_cast<uint64_t>(entry_count_) * sizeof(Entry)) + paths_size;
+    if (HEADER_SIZE + index_size > size) throw GuruMeditation("Invalid archive layout: " + filename);
+    if (mathutils::fnv1a(data + HEADER_SIZE, index_size) != checksum) throw GuruMeditation("Archive checksum mismatch: " + filename);
+    entries_ = reinterpret_cast<const Entry*>(data + HEADER_SIZE);
+    paths_ = data + HEADER_SIZE + (entry_count_ * sizeof(Entry));
+
+    for (uint32_t i = 0; i < entry_count_; i++)
+    {
+        const Entry &entry = entries_[i];
+        const uint64_t data_offset = fileutils::little_endian(entry.data_offset), data_size = fileutils::little_endian(entry.data_size);
+        if (static_cast<uint64_t>(fileutils::little_endian(entry.path_offset)) + fileutils::little_endian(entry.path_length) > paths_size ||
+            data_offset > size || data_size > size - data_offset) throw GuruMeditation("Invalid archive entry: " + filename, i, entry_count_);
+    }
+}
+
+// Destructor, defined where MappedFile is complete.
+Archive::~Archive() = default;
+
+// Checks if a file exists in the archive.
+bool Archive::contains(const std::string &path) const { return find(path) != nullptr; }
+
+// Returns the contents of a file in the archive, or throws if it isn't there.
+std::string_view Archive::file(const std::string &path) const
+{
+    const Entry* entry = find(path);
+    if (!entry) throw GuruMeditation("File not found in archive: " + path);
+    return std::string_view(mapping_->data() + fileutils::little_endian(entry->data_offset), fileutils::little_endian(entry->data_size));
+}
+
+// The number of files in the archive.
+size_t Archive::file_count() const { return entry_count_; }
+
+// Finds a file's index entry, or returns nullptr if it isn't there.
+const Archive::Entry* Archive::find(const std::string &path) const
+{
+    const Entry* end = entries_ + entry_count_;
+    const Entry* entry = std::lower_bound(entries_, end, std::string_view(path), [this](const Entry &e, std::string_view p) { return this->path(e) < p; });
+    if (entry == end || this->path(*entry) != path) return nullptr;
+    return entry;
+}
+
+// Returns the path of an index entry.
+std::string_view Archive::path(const Entry &entry) const
+{ return std::string_view(paths_ + fileutils::little_endian(entry.path_offset), fileutils::little_endian(entry.path_length)); }
+
+// Builds an archive from the specified directory, writing it to a file relative to the game's path. Returns the number of files packed.
+size_t ArchiveBuilder::build(const std::string &source_dir, const std::string &filename)
+{
+    std::vector<std::string> files = fileutils::files_in_dir(source_dir, "", true);
+    std::sort(files.begin(), files.end());
+
+    // The index and path table are built first, as the contents can't be placed until their size is known.
+    std::string path_table;
+    for (const auto &file : files)
+        path_table += file;
+    const uint64_t index_size = (files.size() * sizeof(uint64_t) * 3) + path_table.size();
+    uint64_t data_offset = Archive::HEADER_SIZE + index_size;
+    std::vector<std::string> contents(files.size());
+    std::vector<uint64_t> index;
+    uint32_t path_offset = 0;
+    for (size_t i = 0; i < files.size(); i++)
+    {
+        contents.at(i) = fileutils::file_to_string(BinPath::merge_paths(source_dir, files.at(i)));
+        data_offset = ((data_offset + Archive::BLOB_ALIGNMENT - 1) / Archive::BLOB_ALIGNMENT) * Archive::BLOB_ALIGNMENT;
+        index.push_back(data_offset);
+        index.push_back(contents.at(i).size());
+        index.push_back((static_cast<uint64_t>(path_offset) << 32) | files.at(i).size());   // Entry::path_length and Entry::path_offset, in that order.
+        path_offset += files.at(i).size();
+        data_offset += contents.at(i).size();
+    }
+    for (auto &value : index)
+        value = fileutils::little_endian(value);    // The index is written as-is, so it's converted now, before the checksum is taken.
+    uint64_t checksum = mathutils::fnv1a(index.data(), index.size() * sizeof(uint64_t));
+    checksum = mathutils::fnv1a(path_table.data(), path_table.size(), checksum);
+
+    open_temp_file(filename);
+    write_raw("GPAK", 4);
+    write_data<uint32_t>(Archive::ARCHIVE_VERSION);
+    write_data<uint32_t>(files.size());
+    write_data<uint32_t>(path_table.size());
+    write_data<uint64_t>(checksum);
+    write_data<uint64_t>(data_offset);
+    write_raw(index.data(), index.size() * sizeof(uint64_t));
+    write_raw(path_table.data(), path_table.size());
+    uint64_t written = Archive::HEADER_SIZE + index_size;
+    for (size_t i = 0; i < files.size(); i++)
+    {
+        static constexpr char padding[Archive::BLOB_ALIGNMENT] = {};
+        const uint64_t blob_offset = fileutils::little_endian(index.at(i * 3));
+        write_raw(padding, blob_offset - written);
+        write_raw(contents.at(i).data(), contents.at(i).size());
+        written = blob_offset + contents.at(i).size();
+    }
+    replace_file(filename);
+    return files.size();
+}
+
+}   // namespace gorp
@@ -0,0 +1,61 @@
+// util/file/archive.hpp -- Single-file archives of game data, with a sorted index, memory-mapped so that reading a file never touches the filesystem.
+
+// SPDX-FileType: SOURCE
+// SPDX-FileCopyrightText: Copyright 2025 Raine Simmons <gc@gravecat.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <string_view>
+
+#include "core/global.hpp"
+#include "util/file/filewriter.hpp"
+
+namespace gorp {
+
+class MappedFile;   // defined in util/file/mappedfile.hpp
+
+// A read-only, memory-mapped archive. Opening it costs a single open and mmap, however many files are inside; each file's contents are returned as a
+// view directly into the mapping, and the views stay valid for as long as the Archive does. Only the index is checked when the archive is opened, so the
+// pages holding each file are only read from disk when that file is actually used.
+class Archive {
+public:
+    static constexpr uint32_t   ARCHIVE_VERSION =   1;  // The version changes when archive files are no longer compatible.
+    static constexpr uint32_t   BLOB_ALIGNMENT =    8;  // Each file's contents begin on a multiple of this many bytes.
+    static constexpr uint32_t   HEADER_SIZE =       32; // The size of the file header; the index begins immediately after it.
+
+                Archive() = delete; // No default constructor.
+                Archive(const std::string &filename);   // Maps an archive file (relative to the game's path), and checks its index. Throws on failure.
+                Archive(const Archive&) = delete;   // No copying; each Archive owns its mapping.
+                ~Archive();         // Destructor, defined where MappedFile is complete.
+    bool        contains(const std::string &path) const;    // Checks if a file exists in the archive.
+    std::string_view    file(const std::string &path) const;    // Returns the contents of a file in the archive, or throws if it isn't there.
+    size_t      file_count() const; // The number of files in the archive.
+
+private:
+    // An entry in the index. Entries are sorted by path, so they can be found with a binary search. Every field is little-endian.
+    struct Entry
+    {
+        uint64_t    data_offset;    // The file offset of the contents.
+        uint64_t    data_size;      // The size of the contents, in bytes.
+        uint32_t    path_length;    // The length of the path.
+        uint32_t    path_offset;    // The offset of the path in the path table.
+    };
+
+    const Entry*        find(const std::string &path) const;    // Finds a file's index entry, or returns nullptr if it isn't there.
+    std::string_view    path(const Entry &entry) const;         // Returns the path of an index entry.
+
+    uint32_t            entry_count_;   // The number of entries in the index.
+    const Entry*        entries_;       // The index, inside the mapped file.
+    std::unique_ptr<const MappedFile>   mapping_;   // The mapped archive file.
+    const char*         paths_;         // The path table, inside the mapped file.
+};
+
+// Packs every file in a directory (and its subdirectories) into a new archive file.
+class ArchiveBuilder : public FileWriter {
+public:
+    // Builds an archive from the specified directory, writing it to a file relative to the game's path. Returns the number of files packed.
+    size_t  build(const std::string &source_dir, const std::string &filename);
+};
+
+}   // namespace gorp
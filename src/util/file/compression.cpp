@@ -0,0 +1,228 @@
+// util/file/compression.cpp -- A small, fast LZ77-family block compressor, using the LZ4 block format, for binary save and cache data.
+
+// SPDX-FileType: SOURCE
+// SPDX-FileCopyrightText: Copyright 2025 Raine Simmons <gc@gravecat.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>  // std::memcpy
+
+#include "util/file/compression.hpp"
+
+namespace gorp {
+namespace compression {
+
+static constexpr unsigned int   HASH_BITS =     12; // The size of the match-finding hash table, as a power of two.
+static constexpr size_t         LAST_LITERALS = 5;  // The last bytes of every block are always literals.
+static constexpr size_t         MATCH_LIMIT =   12; // No match may start this close to the end of a block.
+static constexpr size_t         MATCH_MIN =     4;  // The shortest match worth encoding.
+static constexpr size_t         OFFSET_MAX =    65535;  // The furthest back a match can reach.
+
+// Hashes the 4 bytes at the specified position, to look up earlier positions that might match.
+static uint32_t hash_at(const uint8_t* pos)
+{
+    uint32_t value;
+    std::memcpy(&value, pos, sizeof(uint32_t));
+    return (value * 2654435761U) >> (32 - HASH_BITS);
+}
+
+// Checks if the 4 bytes at two positions are the same.
+static bool same4(const uint8_t* a, const uint8_t* b) { return !std::memcmp(a, b, 4); }
+
+// Writes a length that doesn't fit in a token's 4 bits, as a run of 255s followed by the remainder.
+static uint8_t* write_length(uint8_t* out, size_t length)
+{
+    for (; length >= 255; length -= 255)
+        *out++ = 255;
+    *out++ = static_cast<uint8_t>(length);
+    return out;
+}
+
+// Writes a sequence: literals, then optionally a match.
+static uint8_t* write_sequence(uint8_t* out, const uint8_t* literals, size_t literal_count, size_t offset, size_t match_length)
+{
+    uint8_t* token = out++;
+    *token = static_cast<uint8_t>(std::min<size_t>(literal_count, 15) << 4);
+    if (literal_count >= 15) out = write_length(out, literal_count - 15);
+    if (literal_count) std::memcpy(out, literals, literal_count);
+    out += literal_count;
+    if (!match_length) return out;
+
+    *out++ = static_cast<uint8_t>(offset & 0xFF);
+    *out++ = static_cast<uint8_t>(offset >> 8);
+    match_length -= MATCH_MIN;
+    *token |= static_cast<uint8_t>(std::min<size_t>(match_length, 15));
+    if (match_length >= 15) out = write_length(out, match_length - 15);
+    return out;
+}
+
+// Times compressing and decompressing a block of data, and returns a report.
+std::string benchmark(const char* data, size_t size)
+{
+    std::vector<char> packed(compress_bound(BLOCK_SIZE) * ((size / BLOCK_SIZE) + 1)), unpacked(size);
+    std::vector<size_t> block_sizes;
+
+    // Each pass is repeated until enough time has passed to give a stable figure.
+    auto time_pass = [](auto &&pass)
+    {
+        const auto start_time = std::chrono::steady_clock::now();
+        unsigned int runs = 0;
+        do
+        {
+            pass();
+            runs++;
+        } while (std::chrono::steady_clock::now() - start_time < std::chrono::milliseconds(250));
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count() / runs;
+    };
+
+    size_t packed_size = 0;
+    const double compress_time = time_pass([&]
+    {
+        block_sizes.clear();
+        packed_size = 0;
+        for (size_t pos = 0; pos < size; pos += BLOCK_SIZE)
+        {
+            block_sizes.push_back(compress_block(data + pos, std::min(BLOCK_SIZE, size - pos), packed.data() + packed_size));
+            packed_size += block_sizes.back();
+        }
+    });
+    const double decompress_time = time_pass([&]
+    {
+        size_t packed_pos = 0;
+        for (size_t i = 0; i < block_sizes.size(); i++)
+        {
+            const size_t pos = i * BLOCK_SIZE;
+            decompress_block(packed.data() + packed_pos, block_sizes[i], unpacked.data() + pos, std::min(BLOCK_SIZE, size - pos));
+            packed_pos += block_sizes[i];
+        }
+    });
+    if (std::memcmp(data, unpacked.data(), size)) throw GuruMeditation("Compression benchmark failed to round-trip!");
+
+    const double megabytes = static_cast<double>(size) / (1024.0 * 1024.0);
+    return "Compressed " + std::to_string(size) + " bytes to " + std::to_string(packed_size) + " (" + std::to_string(packed_size * 100 / std::max<size_t>(size, 1)) +
+        "%), compress " + std::to_string(static_cast<unsigned int>(megabytes / compress_time)) + " MB/s, decompress " +
+        std::to_string(static_cast<unsigned int>(megabytes / decompress_time)) + " MB/s";
+}
+
+// Compresses a block of data, returning the compressed size.
+size_t compress_block(const char* src, size_t size, char* dest)
+{
+    const uint8_t* const start = reinterpret_cast<const uint8_t*>(src);
+    const uint8_t* const end = start + size;
+    uint8_t* out = reinterpret_cast<uint8_t*>(dest);
+    const uint8_t* anchor = start;  // The start of the literals not yet written.
+    if (size < MATCH_LIMIT + 1) return write_sequence(out, anchor, size, 0, 0) - reinterpret_cast<uint8_t*>(dest);
+
+    // The table holds the last position seen for each hash. Positions are stored relative to the start, so zero is a valid (if unlikely) entry, and
+    // every candidate is checked before it's used anyway.
+    uint32_t table[1 << HASH_BITS] = { };
+    const uint8_t* const match_limit = end - MATCH_LIMIT;
+    const uint8_t* const extend_limit = end - LAST_LITERALS;
+    const uint8_t* pos = start + 1;
+    while (pos < match_limit)
+    {
+        const uint32_t hash = hash_at(pos);
+        const uint8_t* candidate = start + table[hash];
+        table[hash] = static_cast<uint32_t>(pos - start);
+        if (candidate >= pos || static_cast<size_t>(pos - candidate) > OFFSET_MAX || !same4(candidate, pos))
+        {
+            // The further we go without finding a match, the faster we skip ahead, so incompressible data doesn't cost much.
+            pos += 1 + ((pos - anchor) >> 6);
+            continue;
+        }
+
+        // Extend the match backwards into the pending literals, then forwards as far as it goes.
+        while (pos > anchor && candidate > start && pos[-1] == candidate[-1])
+        {
+            pos--;
+            candidate--;
+        }
+        const uint8_t* match_end = pos + MATCH_MIN;
+        const uint8_t* candidate_end = candidate + MATCH_MIN;
+        while (match_end + sizeof(uint64_t) <= extend_limit)
+        {
+            uint64_t a, b;
+            std::memcpy(&a, match_end, sizeof(uint64_t));
+            std::memcpy(&b, candidate_end, sizeof(uint64_t));
+            if (a != b) break;
+            match_end += sizeof(uint64_t);
+            candidate_end += sizeof(uint64_t);
+        }
+        while (match_end < extend_limit && *match_end == *candidate_end)
+        {
+            match_end++;
+            candidate_end++;
+        }
+
+        out = write_sequence(out, anchor, pos - anchor, pos - candidate, match_end - pos);
+        pos = anchor = match_end;
+        if (pos < match_limit) table[hash_at(pos - 2)] = static_cast<uint32_t>(pos - 2 - start);
+    }
+    out = write_sequence(out, anchor, end - anchor, 0, 0);
+    return out - reinterpret_cast<uint8_t*>(dest);
+}
+
+// Decompresses a block of data, which must decompress to exactly dest_size bytes. Throws if the data is malformed; never reads or writes out of bounds.
+void decompress_block(const char* src, size_t src_size, char* dest, size_t dest_size)
+{
+    const uint8_t* in = reinterpret_cast<const uint8_t*>(src);
+    const uint8_t* const in_end = in + src_size;
+    uint8_t* out = reinterpret_cast<uint8_t*>(dest);
+    uint8_t* const out_start = out;
+    uint8_t* const out_end = out + dest_size;
+
+    auto read_length = [&in, in_end](size_t length)
+    {
+        uint8_t byte;
+        do
+        {
+            if (in >= in_end) throw std::runtime_error("Truncated compressed data!");
+            byte = *in++;
+            length += byte;
+        } while (byte == 255);
+        return length;
+    };
+
+    while (true)
+    {
+        if (in >= in_end) throw std::runtime_error("Truncated compressed data!");
+        const uint8_t token = *in++;
+        size_t literal_count = token >> 4;
+        if (literal_count == 15) literal_count = read_length(literal_count);
+        if (literal_count > static_cast<size_t>(in_end - in) || literal_count > static_cast<size_t>(out_end - out))
+            throw std::runtime_error("Invalid compressed literals!");
+        if (literal_count) std::memcpy(out, in, literal_count);
+        in += literal_count;
+        out += literal_count;
+        if (in == in_end) break;    // The last sequence has no match.
+
+        if (in_end - in < 2) throw std::runtime_error("Truncated compressed data!");
+        const size_t offset = in[0] | (in[1] << 8);
+        in += 2;
+        size_t match_length = token & 15;
+        if (match_length == 15) match_length = read_length(match_length);
+        match_length += MATCH_MIN;
+        if (!offset || offset > static_cast<size_t>(out - out_start) || match_length > static_cast<size_t>(out_end - out))
+            throw std::runtime_error("Invalid compressed match!");
+
+        // Matches can overlap the bytes they're producing (a short offset repeats a pattern), so they're copied in steps no longer than the offset.
+        const uint8_t* match = out - offset;
+        if (offset >= match_length) std::memcpy(out, match, match_length);
+        else if (offset >= sizeof(uint64_t))
+        {
+            size_t copied = 0;
+            for (; copied + sizeof(uint64_t) <= match_length; copied += sizeof(uint64_t))
+                std::memcpy(out + copied, match + copied, sizeof(uint64_t));
+            for (; copied < match_length; copied++)
+                out[copied] = match[copied];
+        }
+        else for (size_t i = 0; i < match_length; i++)
+            out[i] = match[i];
+        out += match_length;
+    }
+    if (out != out_end) throw std::runtime_error("Compressed data is the wrong size!");
+}
+
+}   // namespace compression
+}   // namespace gorp
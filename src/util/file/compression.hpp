@@ -0,0 +1,26 @@
+// util/file/compression.hpp -- A small, fast LZ77-family block compressor, using the LZ4 block format, for binary save and cache data.
+
+// SPDX-FileType: SOURCE
+// SPDX-FileCopyrightText: Copyright 2025 Raine Simmons <gc@gravecat.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include "core/global.hpp"
+
+namespace gorp {
+namespace compression {
+
+// Blocks are a series of sequences, each one a token byte (literal count in the high 4 bits, match length minus 4 in the low 4 bits, with 15 meaning
+// more length bytes follow), the literals, then a 16-bit little-endian match offset. The last sequence is literals only. This is the same as an LZ4
+// block, so it trades compression ratio for speed: decompressing is little more than a series of memcpy calls.
+constexpr size_t    BLOCK_SIZE =    64 * 1024;  // Streams are split into independent blocks of this size, which is also the furthest back a match can reach.
+
+std::string     benchmark(const char* data, size_t size);   // Times compressing and decompressing a block of data, and returns a report.
+size_t          compress_block(const char* src, size_t size, char* dest);   // Compresses a block of data, returning the compressed size.
+constexpr size_t    compress_bound(size_t size) { return size + (size / 255) + 16; }    // The largest possible compressed size for a block.
+// Decompresses a block of data, which must decompress to exactly dest_size bytes. Throws if the data is malformed; never reads or writes out of bounds.
+void            decompress_block(const char* src, size_t src_size, char* dest, size_t dest_size);
+
+}   // namespace compression
+}   // namespace gorp
@@ -0,0 +1,213 @@
+// util/file/datapack.cpp -- Compiled binary packs of static game data, memory-mapped and read in place without parsing.
+
+// SPDX-FileType: SOURCE
+// SPDX-FileCopyrightText: Copyright 2025 Raine Simmons <gc@gravecat.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <algorithm>
+#include <cstring>  // std::memcmp, std::memcpy
+
+#include "util/file/binpath.hpp"
+#include "util/file/datapack.hpp"
+#include "util/file/fileutils.hpp"
+#include "util/file/mappedfile.hpp"
+#include "util/math/mathutils.hpp"
+
+namespace gorp {
+
+// The pack file layout is a fixed 32-byte header, followed by the entry table, then the string references for every list, and finally the string table.
+// Everything before the string table is made of 32-bit values, so it stays aligned when the file is memory-mapped. Every value is little-endian, as in
+// every other binary file. The tables are read in place, so each value is passed through fileutils::little_endian() as it's read.
+//
+//  0   char[4]     "K10P" magic
+//  4   uint32_t    DATAPACK_VERSION
+//  8   uint64_t    hash of the source data the pack was compiled from
+//  16  uint64_t    FNV-1a checksum of everything after the header
+//  24  uint32_t    entry count
+//  28  uint32_t    string table offset (the string table runs to the end of the file)
+
+// Maps a pack file (relative to the game's path), and checks that it's intact, and that it was compiled from source data with the specified hash.
+// Throws on failure.
+DataPack::DataPack(const std::string &filename, uint64_t source_hash) : entry_count_(0), entries_(nullptr), mapping_(nullptr), strings_(nullptr)
+{
+    const std::string full_path = BinPath::game_path(filename);
+    if (!fileutils::file_exists(full_path)) throw GuruMeditation("Data pack not found: " + filename);
+    mapping_ = std::make_unique<const MappedFile>(full_path);
+    const char* data = mapping_->data();
+    const size_t size = mapping_->size();
+    if (size < HEADER_SIZE || std::memcmp(data, "K10P", 4)) throw GuruMeditation("Invalid data pack: " + filename);
+
+    uint32_t version, strings_offset;
+    uint64_t file_source_hash, checksum;
+    std::memcpy(&version, data + 4, sizeof(uint32_t));
+    std::memcpy(&file_source_hash, data + 8, sizeof(uint64_t));
+    std::memcpy(&checksum, data + 16, sizeof(uint64_t));
+    std::memcpy(&entry_count_, data + 24, sizeof(uint32_t));
+    std::memcpy(&strings_offset, data + 28, sizeof(uint32_t));
+    version = fileutils::little_endian(version);
+    file_source_hash = fileutils::little_endian(file_source_hash);
+    checksum = fileutils::little_endian(checksum);
+    entry_count_ = fileutils::little_endian(entry_count_);
+    strings_offset = fileutils::little_endian(strings_offset);
+    if (version != DATAPACK_VERSION) throw GuruMeditation("Data pack version mismatch: " + filename, version, DATAPACK_VERSION);
+    if (file_source_hash != source_hash) throw GuruMeditation("Data pack is out of date: " + filename);
+    if (mathutils::fnv1a(data + HEADER_SIZE, size - HEADER_SIZE) != checksum) throw GuruMeditation("Data pack checksum mismatch: " + filename);
+    if (HEADER_SIZE + (static_cast<uint64_t>(entry_count_) * sizeof(Entry)) > strings_offset || strings_offset > size)
+        throw GuruMeditation("Invalid data pack layout: " + filename);
+    entries_ = reinterpret_cast<const Entry*>(data + HEADER_SIZE);
+    strings_ = data + strings_offset;
+
+    // The checksum only proves the file is the one that was written, so check every offset once now, rather than on every lookup.
+    const uint64_t strings_size = size - strings_offset;
+    auto check_text = [strings_size, &filename](uint32_t offset, uint32_t length)
+    { if (static_cast<uint64_t>(offset) + length > strings_size) throw GuruMeditation("Invalid data pack string: " + filename, offset, length); };
+    for (uint32_t i = 0; i < entry_count_; i++)
+    {
+        const Entry &entry = entries_[i];
+        const uint32_t type = fileutils::little_endian(entry.type);
+        const uint32_t value_count = fileutils::little_endian(entry.value_count), value_offset = fileutils::little_endian(entry.value_offset);
+        check_text(fileutils::little_endian(entry.key_offset), fileutils::little_endian(entry.key_length));
+        if (type == TYPE_STRING) check_text(value_offset, value_count);
+        else if (type == TYPE_LIST)
+        {
+            const uint64_t refs_end = value_offset + (static_cast<uint64_t>(value_count) * sizeof(uint32_t) * 2);
+            if (value_offset % sizeof(uint32_t) || value_offset < HEADER_SIZE || refs_end > strings_offset)
+                throw GuruMeditation("Invalid data pack list: " + filename, value_offset, value_count);
+            const uint32_t* refs = reinterpret_cast<const uint32_t*>(data + value_offset);
+            for (uint32_t r = 0; r < value_count; r++)
+                check_text(fileutils::little_endian(refs[r * 2]), fileutils::little_endian(refs[(r * 2) + 1]));
+        }
+        else throw GuruMeditation("Invalid data pack entry type: " + filename, type);
+    }
+}
+
+// Destructor, defined where MappedFile is complete.
+DataPack::~DataPack() = default;
+
+// Finds an entry of the specified type, or throws if there isn't one.
+const DataPack::Entry* DataPack::find(const std::string &key, uint32_t type) const
+{
+    const Entry* end = entries_ + entry_count_;
+    const Entry* entry = std::lower_bound(entries_, end, std::string_view(key), [this](const Entry &e, std::string_view k) { return this->key(e) < k; });
+    if (entry == end || this->key(*entry) != key) throw GuruMeditation("Missing data pack entry: " + key);
+    const uint32_t entry_type = fileutils::little_endian(entry->type);
+    if (entry_type != type) throw GuruMeditation("Data pack entry has the wrong type: " + key, entry_type, type);
+    return entry;
+}
+
+// Checks if an entry exists.
+bool DataPack::has(const std::string &key) const
+{
+    const Entry* end = entries_ + entry_count_;
+    const Entry* entry = std::lower_bound(entries_, end, std::string_view(key), [this](const Entry &e, std::string_view k) { return this->key(e) < k; });
+    return entry != end && this->key(*entry) == key;
+}
+
+// Returns the key of an entry.
+std::string_view DataPack::key(const Entry &entry) const
+{ return text(fileutils::little_endian(entry.key_offset), fileutils::little_endian(entry.key_length)); }
+
+// Returns a list entry.
+DataPack::StringList DataPack::list(const std::string &key) const
+{
+    const Entry* entry = find(key, TYPE_LIST);
+    return StringList(*this, reinterpret_cast<const uint32_t*>(mapping_->data() + fileutils::little_endian(entry->value_offset)),
+        fileutils::little_endian(entry->value_count));
+}
+
+// Returns a string entry.
+std::string_view DataPack::string(const std::string &key) const
+{
+    const Entry* entry = find(key, TYPE_STRING);
+    return text(fileutils::little_endian(entry->value_offset), fileutils::little_endian(entry->value_count));
+}
+
+// Returns a view of part of the string table.
+std::string_view DataPack::text(uint32_t offset, uint32_t length) const { return std::string_view(strings_ + offset, length); }
+
+// Bounds-checked access to a string in the list.
+std::string_view DataPack::StringList::at(size_t index) const
+{
+    if (index >= count_) throw GuruMeditation("Invalid data pack list index!", index, count_);
+    return (*this)[index];
+}
+
+// Copies the list into a vector of strings.
+std::vector<std::string> DataPack::StringList::to_vector() const
+{
+    std::vector<std::string> vec;
+    vec.reserve(count_);
+    for (size_t i = 0; i < count_; i++)
+        vec.emplace_back((*this)[i]);
+    return vec;
+}
+
+// Adds a list of strings.
+void DataPackBuilder::add_list(const std::string &key, const std::vector<std::string> &values) { entries_[key] = { DataPack::TYPE_LIST, values }; }
+
+// Adds a single string.
+void DataPackBuilder::add_string(const std::string &key, const std::string &value) { entries_[key] = { DataPack::TYPE_STRING, { value } }; }
+
+// Adds a string to the string table, if it isn't already there, and returns its offset.
+uint32_t DataPackBuilder::intern(const std::string &str)
+{
+    auto it = interned_.find(str);
+    if (it != interned_.end()) return it->second;
+    const uint32_t offset = string_table_.size();
+    string_table_ += str;
+    interned_[str] = offset;
+    return offset;
+}
+
+// Writes the pack to a file, relative to the game's path.
+void DataPackBuilder::save(const std::string &filename, uint64_t source_hash)
+{
+    // The body is built in memory first, as the header needs its checksum.
+    std::vector<uint32_t> table, refs;
+    const uint32_t refs_offset = DataPack::HEADER_SIZE + (entries_.size() * 5 * sizeof(uint32_t));
+    for (const auto &[key, entry] : entries_)
+    {
+        const auto &[type, values] = entry;
+        table.push_back(key.size());
+        table.push_back(intern(key));
+        table.push_back(type);
+        if (type == DataPack::TYPE_STRING)
+        {
+            table.push_back(values.at(0).size());
+            table.push_back(intern(values.at(0)));
+        }
+        else
+        {
+            table.push_back(values.size());
+            table.push_back(refs_offset + (refs.size() * sizeof(uint32_t)));
+            for (const auto &value : values)
+            {
+                refs.push_back(intern(value));
+                refs.push_back(value.size());
+            }
+        }
+    }
+    const uint32_t strings_offset = refs_offset + (refs.size() * sizeof(uint32_t));
+    // The tables are written as-is, so they're converted now, before the checksum is taken.
+    for (auto &value : table)
+        value = fileutils::little_endian(value);
+    for (auto &value : refs)
+        value = fileutils::little_endian(value);
+    uint64_t checksum = mathutils::fnv1a(table.data(), table.size() * sizeof(uint32_t));
+    checksum = mathutils::fnv1a(refs.data(), refs.size() * sizeof(uint32_t), checksum);
+    checksum = mathutils::fnv1a(string_table_.data(), string_table_.size(), checksum);
+
+    open_temp_file(filename);
+    write_raw("K10P", 4);
+    write_data<uint32_t>(DataPack::DATAPACK_VERSION);
+    write_data<uint64_t>(source_hash);
+    write_data<uint64_t>(checksum);
+    write_data<uint32_t>(entries_.size());
+    write_data<uint32_t>(strings_offset);
+    write_raw(table.data(), table.size() * sizeof(uint32_t));
+    write_raw(refs.data(), refs.size() * sizeof(uint32_t));
+    write_raw(string_table_.data(), string_table_.size());
+    replace_file(filename);
+}
+
+}   // namespace gorp
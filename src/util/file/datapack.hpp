@@ -0,0 +1,91 @@
+// util/file/datapack.hpp -- Compiled binary packs of static game data, memory-mapped and read in place without parsing.
+
+// SPDX-FileType: SOURCE
+// SPDX-FileCopyrightText: Copyright 2025 Raine Simmons <gc@gravecat.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <map>
+#include <string_view>
+#include <unordered_map>
+
+#include "core/global.hpp"
+#include "util/file/filewriter.hpp"
+
+namespace gorp {
+
+class MappedFile;   // defined in util/file/mappedfile.hpp
+
+// A read-only, memory-mapped data pack. Every entry is a string or a list of strings, looked up by key, and every string is a view directly into the
+// mapped file, so nothing is copied or parsed; the views stay valid for as long as the DataPack does.
+class DataPack {
+public:
+    static constexpr uint32_t   DATAPACK_VERSION =  1;  // The version changes when pack files are no longer compatible.
+    static constexpr uint32_t   HEADER_SIZE =       32; // The size of the file header; the entry table begins immediately after it.
+    static constexpr uint32_t   TYPE_STRING =       0;  // Entry type for a single string.
+    static constexpr uint32_t   TYPE_LIST =         1;  // Entry type for a list of strings.
+
+    // A view over a list of strings inside a DataPack.
+    class StringList {
+    public:
+                            StringList(const DataPack &pack, const uint32_t* refs, uint32_t count) : count_(count), pack_(pack), refs_(refs) { }
+        std::string_view    operator[](size_t index) const  // Unchecked access to a string in the list.
+        { return pack_.text(fileutils::little_endian(refs_[index * 2]), fileutils::little_endian(refs_[(index * 2) + 1])); }
+        std::string_view    at(size_t index) const; // Bounds-checked access to a string in the list.
+        size_t              size() const { return count_; } // The number of strings in the list.
+        std::vector<std::string>    to_vector() const;  // Copies the list into a vector of strings.
+
+    private:
+        uint32_t            count_; // The number of strings in the list.
+        const DataPack      &pack_; // The pack the strings live in.
+        const uint32_t*     refs_;  // The offset and length of each string in the pack's string table, little-endian.
+    };
+
+                DataPack() = delete;    // No default constructor.
+                // Maps a pack file (relative to the game's path), and checks that it's intact, and that it was compiled from source data with the
+                // specified hash. Throws on failure.
+                DataPack(const std::string &filename, uint64_t source_hash);
+                DataPack(const DataPack&) = delete; // No copying, as StringLists refer back to the pack.
+                ~DataPack();            // Destructor, defined where MappedFile is complete.
+    bool        has(const std::string &key) const;  // Checks if an entry exists.
+    StringList  list(const std::string &key) const; // Returns a list entry.
+    std::string_view    string(const std::string &key) const;   // Returns a string entry.
+
+private:
+    // An entry in the table at the start of the pack. Entries are sorted by key, so they can be found with a binary search. Every field is little-endian.
+    struct Entry
+    {
+        uint32_t    key_length;     // The length of the key.
+        uint32_t    key_offset;     // The offset of the key in the string table.
+        uint32_t    type;           // TYPE_STRING or TYPE_LIST.
+        uint32_t    value_count;    // For strings, the string's length; for lists, the number of strings.
+        uint32_t    value_offset;   // For strings, the offset in the string table; for lists, the file offset of the list's string references.
+    };
+
+    const Entry*        find(const std::string &key, uint32_t type) const;  // Finds an entry of the specified type, or throws if there isn't one.
+    std::string_view    key(const Entry &entry) const;  // Returns the key of an entry.
+    std::string_view    text(uint32_t offset, uint32_t length) const;       // Returns a view of part of the string table.
+
+    uint32_t            entry_count_;   // The number of entries in the table.
+    const Entry*        entries_;       // The entry table, inside the mapped file.
+    std::unique_ptr<const MappedFile>   mapping_;   // The mapped pack file.
+    const char*         strings_;       // The string table, inside the mapped file.
+};
+
+// Compiles entries into a new data pack file. Identical strings are only stored once.
+class DataPackBuilder : public FileWriter {
+public:
+    void    add_list(const std::string &key, const std::vector<std::string> &values);   // Adds a list of strings.
+    void    add_string(const std::string &key, const std::string &value);   // Adds a single string.
+    void    save(const std::string &filename, uint64_t source_hash);        // Writes the pack to a file, relative to the game's path.
+
+private:
+    uint32_t    intern(const std::string &str); // Adds a string to the string table, if it isn't already there, and returns its offset.
+
+    std::map<std::string, std::pair<uint32_t, std::vector<std::string>>>    entries_;   // The type and value(s) of each entry, sorted by key.
+    std::unordered_map<std::string, uint32_t>   interned_;  // The offset of every string already in the string table.
+    std::string     string_table_;  // Every string in the pack, back to back.
+};
+
+}   // namespace gorp
@@ -4,47 +4,149 @@
 // SPDX-FileCopyrightText: Copyright 2025 Raine Simmons <gc@gravecat.com>
 // SPDX-License-Identifier: GPL-3.0-or-later
 
-#include <fstream>
+#include <algorithm>
 
 #include "core/core.hpp"
+#include "util/file/compression.hpp"
 #include "util/file/filereader.hpp"
 #include "util/file/fileutils.hpp"
+#include "util/file/mappedfile.hpp"
 
 namespace gorp {
 
-// Loads a data file into memory.
-FileReader::FileReader(std::string filename, bool allow_missing_file) : read_index_(0)
-{   
+// Maps a data file into memory.
+FileReader::FileReader(const std::string &filename, bool allow_missing_file) : data_(nullptr), data_size_(0), mapping_(nullptr), read_index_(0)
+{
     if (!fileutils::file_exists(filename))
     {
         if (allow_missing_file) return;
         else throw std::runtime_error("Cannot load file: " + filename);
     }
-    std::ifstream file(filename, std::ios::binary | std::ios::ate);
-    if (!file.is_open()) throw std::runtime_error("Cannot load file: " + filename);
-    std::streampos file_size = file.tellg();
-    file.seekg(0, std::ios::beg);
-    data_.resize(static_cast<size_t>(file_size));
-    file.read(data_.data(), file_size);
-    file.close();
+    mapping_ = std::make_unique<const MappedFile>(filename);
+    data_ = mapping_->data();
+    data_size_ = mapping_->size();
+}
+
+// Reads from a block of memory instead of a file. The memory must outlive the FileReader.
+FileReader::FileReader(const char* data, size_t size) : data_(data), data_size_(size), mapping_(nullptr), read_index_(0) { }
+
+// Destructor, defined where MappedFile is complete.
+FileReader::~FileReader() = default;
+
+// Unmaps the file, once everything needed has been read. Invalidates any views.
+void FileReader::close_reader()
+{
+    // Some platforms won't let a file be replaced while it's still mapped, so anything that saves over the file it loaded from has to call this first.
+    mapping_.reset(nullptr);
+    data_ = nullptr;
+    data_size_ = read_index_ = 0;
 }
 
+// The size of the mapped file, in bytes; 0 if no file was loaded.
+size_t FileReader::file_size() const { return data_size_; }
+
+// The current read position in the file.
+size_t FileReader::position() const { return read_index_; }
+
 // Reads a blob of binary data, in the form of a std::vector<char>
 std::vector<char> FileReader::read_char_vec()
 {
-    const uint32_t size = read_data<uint32_t>();
-    std::vector<char> buffer(data_.begin() + read_index_, data_.begin() + read_index_ + size);
-    read_index_ += size;
-    return buffer;
+    const std::string_view view = read_view(read_data<uint32_t>());
+    return std::vector<char>(view.begin(), view.end());
+}
+
+// Reads a block of data written by FileWriter::write_compressed(), of a known size.
+void FileReader::read_compressed(void* dest, size_t size)
+{
+    if (read_varint() != size) throw std::runtime_error("Compressed data is the wrong size!");
+    char* bytes = static_cast<char*>(dest);
+    for (size_t pos = 0; pos < size; pos += compression::BLOCK_SIZE)
+    {
+        const size_t block_size = std::min(compression::BLOCK_SIZE, size - pos);
+        const uint32_t header = read_data<uint32_t>();
+        const std::string_view stored = read_view(header >> 1);
+        if (!(header & 1)) compression::decompress_block(stored.data(), stored.size(), bytes + pos, block_size);
+        else if (stored.size() == block_size) std::memcpy(bytes + pos, stored.data(), block_size);
+        else throw std::runtime_error("Stored block is the wrong size!");
+    }
+}
+
+// Reads a file header written by FileWriter::write_header(), returning the schema version.
+uint32_t FileReader::read_header(uint32_t magic)
+{
+    if (remaining() < sizeof(uint32_t) || read_data_unchecked<uint32_t>() != magic) throw std::runtime_error("Invalid file header!");
+    const uint64_t version = read_varint();
+    if (version > UINT32_MAX) throw std::runtime_error("Invalid file version!");
+    return static_cast<uint32_t>(version);
+}
+
+// Reads the tag and length of the next section, leaving the read position at the start of its contents. Returns false at the end of the file.
+bool FileReader::read_section(uint32_t &tag, size_t &length)
+{
+    if (!remaining()) return false;
+    require(sizeof(uint32_t) + sizeof(uint64_t));
+    tag = read_data_unchecked<uint32_t>();
+    const uint64_t section_length = read_data_unchecked<uint64_t>();
+    require(section_length);    // Checking the whole section now means its fields can be read with read_data_unchecked().
+    length = section_length;
+    return true;
 }
 
 // Reads a string from the loaded file.
-std::string FileReader::read_string()
+std::string FileReader::read_string() { return std::string(read_string_view()); }
+
+// Reads a string from the loaded file, as a view into the mapping, without copying it.
+std::string_view FileReader::read_string_view() { return read_view(read_data<uint32_t>()); }
+
+// Reads an unsigned LEB128 varint.
+uint64_t FileReader::read_varint()
+{
+    uint64_t value = 0;
+    for (unsigned int shift = 0; shift < 64; shift += 7)
+    {
+        require(1);
+        const uint8_t byte = static_cast<uint8_t>(data_[read_index_++]);
+        if (shift == 63 && byte > 1) throw std::runtime_error("Varint overflow!");  // Only the lowest bit of the tenth byte fits in 64 bits.
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return value;
+    }
+    throw std::runtime_error("Invalid varint!");
+}
+
+// Reads a zigzag-encoded signed varint.
+int64_t FileReader::read_varint_signed()
+{
+    const uint64_t value = read_varint();
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+// Returns a view of the next block of data, without copying it.
+std::string_view FileReader::read_view(size_t size)
 {
-    uint32_t len = read_data<uint32_t>();
-    std::string result(data_.begin() + read_index_, data_.begin() + read_index_ + len);
-    read_index_ += len;
-    return result;
+    require(size);
+    const std::string_view view(data_ + read_index_, size);
+    read_index_ += size;
+    return view;
+}
+
+// The number of bytes left to read.
+size_t FileReader::remaining() const { return data_size_ - read_index_; }
+
+// Throws if fewer than the specified number of bytes are left to read.
+void FileReader::require(size_t size) const { if (size > remaining()) throw std::runtime_error("Attempt to read out-of-bounds data!"); }
+
+// Moves the read position to an offset from the start of the file.
+void FileReader::seek(size_t pos)
+{
+    if (pos > data_size_) throw std::runtime_error("Attempt to seek out of bounds!");
+    read_index_ = pos;
+}
+
+// Skips past a block of data, such as an unrecognized section.
+void FileReader::skip(size_t size)
+{
+    require(size);
+    read_index_ += size;
 }
 
-};
+}   // namespace gorp
@@ -7,32 +7,64 @@
 #pragma once
 
 #include <cstring>  // std::memcpy
+#include <string_view>
 
 #include "core/global.hpp"
+#include "util/file/fileutils.hpp"
 
 namespace gorp {
 
+class MappedFile;   // defined in util/file/mappedfile.hpp
+
+// The file is memory-mapped rather than read into a buffer, so even large files cost no more memory than the parts actually read, and views returned by
+// read_view() and read_string_view() point straight into the mapping; they stay valid until close_reader() is called, or the FileReader is destroyed.
+// This reads everything FileWriter writes: little-endian fixed-size values, varints, headers, and tagged sections.
 class FileReader {
 public:
                         FileReader() = delete;  // No default constructor.
-                        FileReader(std::string filename, bool allow_missing_file = false);  // Loads a data file into memory.
-    std::vector<char>   read_char_vec();    // Reads a blob of binary data, in the form of a std::vector<char>
-    std::string         read_string();      // Reads a string from the loaded file.
+                        FileReader(const std::string &filename, bool allow_missing_file = false);   // Maps a data file into memory.
+                        FileReader(const char* data, size_t size);  // Reads from a block of memory instead of a file. The memory must outlive the FileReader.
+                        FileReader(const FileReader&) = delete; // No copying; each FileReader owns its mapping.
+                        ~FileReader();          // Destructor, defined where MappedFile is complete.
+    void                close_reader();         // Unmaps the file, once everything needed has been read. Invalidates any views.
+    size_t              file_size() const;      // The size of the mapped file, in bytes; 0 if no file was loaded.
+    size_t              position() const;       // The current read position in the file.
+    std::vector<char>   read_char_vec();        // Reads a blob of binary data, in the form of a std::vector<char>
+    void                read_compressed(void* dest, size_t size);   // Reads a block of data written by FileWriter::write_compressed(), of a known size.
+    uint32_t            read_header(uint32_t magic);    // Reads a file header written by FileWriter::write_header(), returning the schema version.
+    // Reads the tag and length of the next section, leaving the read position at the start of its contents. Returns false at the end of the file.
+    bool                read_section(uint32_t &tag, size_t &length);
+    std::string         read_string();          // Reads a string from the loaded file.
+    std::string_view    read_string_view();     // Reads a string from the loaded file, as a view into the mapping, without copying it.
+    uint64_t            read_varint();          // Reads an unsigned LEB128 varint.
+    int64_t             read_varint_signed();   // Reads a zigzag-encoded signed varint.
+    std::string_view    read_view(size_t size); // Returns a view of the next block of data, without copying it.
+    size_t              remaining() const;      // The number of bytes left to read.
+    void                require(size_t size) const; // Throws if fewer than the specified number of bytes are left to read.
+    void                seek(size_t pos);       // Moves the read position to an offset from the start of the file.
+    void                skip(size_t size);      // Skips past a block of data, such as an unrecognized section.
 
     // Reads data from a loaded file.
     template<typename T> T  read_data()
     {
-        if (read_index_ + sizeof(T) > data_.size()) throw std::runtime_error("Attmept to read out-of-bounds data!");
-        char* mid_pos = data_.data() + read_index_;
+        require(sizeof(T));
+        return read_data_unchecked<T>();
+    }
+
+    // As above, but without the bounds check, for when require() has already been called for a whole block of fields.
+    template<typename T> T  read_data_unchecked()
+    {
         T result;
-        std::memcpy(&result, mid_pos, sizeof(T));
+        std::memcpy(&result, data_ + read_index_, sizeof(T));
         read_index_ += sizeof(T);
-        return result;
+        return fileutils::little_endian(result);
     }
 
 protected:
-    std::vector<char>   data_;          // The data file loaded into memory.
-    uint32_t            read_index_;    // The current read position in the file.
+    const char*         data_;          // The mapped data file (or the block of memory being read), or nullptr if no file was loaded.
+    size_t              data_size_;     // The size of the mapped data file, in bytes.
+    std::unique_ptr<const MappedFile>   mapping_;   // The mapped data file.
+    size_t              read_index_;    // The current read position in the file.
 };
 
 }   // namespace gorp
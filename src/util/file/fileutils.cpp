@@ -4,11 +4,18 @@
 // SPDX-FileCopyrightText: Copyright 2025 Raine Simmons <gc@gravecat.com>
 // SPDX-License-Identifier: GPL-3.0-or-later
 
+#ifdef GORP_TARGET_WINDOWS
+#include <windows.h>    // CreateFileA(), FlushFileBuffers(), MoveFileExA()
+#else
+#include <fcntl.h>      // open()
+#endif
+
+#include <cstdio>       // std::rename()
 #include <dirent.h>     // DIR, dirent, opendir(), readdir(), closedir()
 #include <fstream>
 #include <sstream>
 #include <sys/stat.h>   // stat(), mkdir()
-#include <unistd.h>     // unlink()
+#include <unistd.h>     // unlink(), fsync(), close()
 
 #include "util/file/fileutils.hpp"
 #include "util/text/stringutils.hpp"
@@ -146,4 +153,34 @@ void make_dir(const std::string &dir)
 #endif
 }
 
+// Renames a file, replacing the destination if it already exists.
+void rename_file(const std::string &from, const std::string &to)
+{
+#ifdef GORP_TARGET_WINDOWS
+    // std::rename() refuses to replace an existing file on Windows, and deleting it first would leave a moment with neither file in place.
+    if (!MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)) throw std::runtime_error("Cannot rename file: " + from);
+#else
+    if (std::rename(from.c_str(), to.c_str()) != 0) throw std::runtime_error("Cannot rename file: " + from);
+#endif
+}
+
+// Forces a file's contents out to the disk, so they survive a power cut or OS crash, not just the game crashing. On platforms that support it, a directory
+// can be synced too, to make a rename within it permanent.
+void sync_file(const std::string &filename)
+{
+#ifdef GORP_TARGET_WINDOWS
+    if (directory_exists(filename)) return; // MoveFileExA() with MOVEFILE_WRITE_THROUGH already makes renames permanent.
+    HANDLE file = CreateFileA(filename.c_str(), GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) throw std::runtime_error("Cannot open file: " + filename);
+    const bool synced = FlushFileBuffers(file);
+    CloseHandle(file);
+#else
+    const int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) throw std::runtime_error("Cannot open file: " + filename);
+    const bool synced = !fsync(fd);
+    close(fd);
+#endif
+    if (!synced) throw std::runtime_error("Cannot sync file to disk: " + filename);
+}
+
 } } // namespace fileutils, gorp
@@ -6,11 +6,30 @@
 
 #pragma once
 
+#include <algorithm>
+#include <type_traits>
+
 #include "core/global.hpp"
 
 namespace gorp {
 namespace fileutils {
 
+// Packs a four-character code (such as a file magic number or section tag) into an integer, which is written to files as those four characters in order.
+constexpr uint32_t  fourcc(const char (&code)[5])
+{ return static_cast<uint8_t>(code[0]) | (static_cast<uint8_t>(code[1]) << 8) | (static_cast<uint8_t>(code[2]) << 16) |
+    (static_cast<uint32_t>(static_cast<uint8_t>(code[3])) << 24); }
+
+// Converts a value between the host's byte order and little-endian, the byte order used in every binary file. This does nothing on little-endian hosts.
+template<typename T> T  little_endian(T value)
+{
+    static_assert(std::is_trivially_copyable_v<T>, "little_endian() needs a trivially copyable type");
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    char* bytes = reinterpret_cast<char*>(&value);
+    std::reverse(bytes, bytes + sizeof(T));
+#endif
+    return value;
+}
+
 void        delete_file(const std::string &filename);       // Deletes a specified file.
 bool        directory_exists(const std::string &dir);       // Check if a directory exists.
 bool        file_exists(const std::string &file);           // Checks if a file exists.
@@ -20,5 +39,9 @@ std::vector<char>           file_to_char_vec(const std::string &filename);  // L
 std::string file_to_string(const std::string &filename);    // Loads a text file into an std::string.
 std::vector<std::string>    file_to_vec(const std::string &filename);   // Loads a text file into a vector, one string for each line of the file.
 void        make_dir(const std::string &dir);               // Makes a new directory, if it doesn't already exist.
+void        rename_file(const std::string &from, const std::string &to);    // Renames a file, replacing the destination if it already exists.
+// Forces a file's contents out to the disk, so they survive a power cut or OS crash, not just the game crashing. On platforms that support it, a directory
+// can be synced too, to make a rename within it permanent.
+void        sync_file(const std::string &filename);
 
 } } // fileutils, gorp namespaces
@@ -4,36 +4,223 @@
 // SPDX-FileCopyrightText: Copyright 2025 Raine Simmons <gc@gravecat.com>
 // SPDX-License-Identifier: GPL-3.0-or-later
 
+#include <algorithm>
+
 #include "util/file/binpath.hpp"
+#include "util/file/compression.hpp"
 #include "util/file/fileutils.hpp"
 #include "util/file/filewriter.hpp"
 
 namespace gorp {
 
+// Constructor, sets up the write buffer.
+FileWriter::FileWriter() : flushed_(0), memory_(false) { }
+
+// Destructor, flushes anything still buffered.
+FileWriter::~FileWriter() { if (file_out_.is_open()) flush(); }
+
+// Begins a new section, identified by a tag from fileutils::fourcc(). Sections can be nested.
+void FileWriter::begin_section(uint32_t tag)
+{
+    // The length isn't known yet, so a placeholder is written, and filled in by end_section().
+    write_data<uint32_t>(tag);
+    sections_.push_back(position());
+    write_data<uint64_t>(0);
+}
+
 // Closes the binary file.
-void FileWriter::close_file() { file_out_.close(); }
+void FileWriter::close_file()
+{
+    if (sections_.size()) throw GuruMeditation("Closing file with unfinished sections!", sections_.size());
+    flush();
+    file_out_.close();
+}
+
+// Ends the current section, filling in its length.
+void FileWriter::end_section()
+{
+    if (!sections_.size()) throw GuruMeditation("Attempt to end a section that was never begun!");
+    const uint64_t length_pos = sections_.back();
+    sections_.pop_back();
+    const uint64_t length = fileutils::little_endian(position() - length_pos - sizeof(uint64_t));
+
+    // Usually the placeholder is still in the buffer, but for large sections, it may already be in the file.
+    if (length_pos >= flushed_) std::memcpy(buffer_.data() + (length_pos - flushed_), &length, sizeof(uint64_t));
+    else
+    {
+        flush();
+        file_out_.seekp(length_pos);
+        file_out_.write(reinterpret_cast<const char*>(&length), sizeof(uint64_t));
+        file_out_.seekp(0, std::ios::end);
+    }
+}
+
+// Checks if anything written to the file so far has failed, including closing it.
+bool FileWriter::failed() const { return file_out_.fail(); }
+
+// Writes the buffer out to the file.
+void FileWriter::flush()
+{
+    if (memory_) return;    // When writing into memory, the buffer is the destination.
+    file_out_.write(buffer_.data(), buffer_.size());
+    flushed_ += buffer_.size();
+    buffer_.clear();
+}
 
-// Opens a file for writing.
-void FileWriter::open_file(std::string filename)
+// Opens a file for writing, or for appending to the end of an existing file.
+void FileWriter::open_file(std::string filename, bool append)
 {
     filename = BinPath::game_path(filename);
+    buffer_.clear();
+    buffer_.reserve(BUFFER_SIZE);
+    flushed_ = 0;
+    memory_ = false;
+    sections_.clear();
+    file_out_.clear();
+
+    // std::ios::app isn't used for appending, as it would send every write to the end of the file, including end_section() filling in lengths.
+    if (append && fileutils::file_exists(filename))
+    {
+        file_out_.open(filename.c_str(), std::ios::binary | std::ios::in | std::ios::out);
+        file_out_.seekp(0, std::ios::end);
+        flushed_ = static_cast<uint64_t>(file_out_.tellp());
+        return;
+    }
     fileutils::delete_file(filename);
     file_out_.open(filename.c_str(), std::ios::binary | std::ios::out);
 }
 
+// Starts writing into memory instead of a file.
+void FileWriter::open_memory()
+{
+    buffer_.clear();
+    flushed_ = 0;
+    memory_ = true;
+    sections_.clear();
+}
+
+// Opens a temporary file to write a new copy of filename into, for replace_file().
+void FileWriter::open_temp_file(const std::string &filename) { open_file(temp_filename(filename)); }
+
+// The current write position, in bytes from the start of the file.
+uint64_t FileWriter::position() const { return flushed_ + buffer_.size(); }
+
+// Closes the temporary file opened by open_temp_file(), syncs it to the disk, and renames it over filename. Throws if anything failed to write.
+void FileWriter::replace_file(const std::string &filename)
+{
+    // Writing a whole new copy and renaming it over the old one means filename is only ever the complete old file or the complete new one, never
+    // something partially written, even if the game crashes part-way through. If the new copy didn't write properly, it's thrown away, and the old file
+    // is left as it was.
+    const std::string temp_path = BinPath::game_path(temp_filename(filename)), path = BinPath::game_path(filename);
+    close_file();
+    if (failed())
+    {
+        fileutils::delete_file(temp_path);
+        throw std::runtime_error("Could not write file: " + temp_path);
+    }
+
+    // The new file has to be on the disk before it replaces the old one, or a power cut could leave the rename done but the contents missing. Then the
+    // directory is synced, so the rename itself isn't lost.
+    fileutils::sync_file(temp_path);
+    fileutils::rename_file(temp_path, path);
+    const size_t last_slash = path.find_last_of("/\\");
+    if (last_slash != std::string::npos) fileutils::sync_file(path.substr(0, last_slash));
+}
+
+// Finishes writing into memory, and returns everything that was written.
+std::string FileWriter::take_memory()
+{
+    if (!memory_) throw GuruMeditation("Attempt to take memory from a FileWriter writing to a file!");
+    if (sections_.size()) throw GuruMeditation("Taking memory with unfinished sections!", sections_.size());
+    std::string data(buffer_.begin(), buffer_.end());
+    buffer_.clear();
+    memory_ = false;
+    return data;
+}
+
+// The temporary file used by open_temp_file() and replace_file().
+std::string FileWriter::temp_filename(const std::string &filename) { return filename + ".tmp"; }
+
 // Writes binary data (in the form of an std::vector<char>) to the binary file.
 void FileWriter::write_char_vec(std::vector<char> vec)
 {
     write_data<uint32_t>(vec.size());
-    file_out_.write(vec.data(), vec.size());
+    write_raw(vec.data(), vec.size());
+}
+
+// Writes a block of data compressed in blocks, for FileReader::read_compressed().
+void FileWriter::write_compressed(const void* data, size_t size)
+{
+    // The total size comes first, then each block of up to compression::BLOCK_SIZE bytes is prefixed with a uint32_t holding its stored size shifted
+    // left by one, with the low bit set if the block couldn't be compressed and was stored as-is instead.
+    write_varint(size);
+    const char* bytes = static_cast<const char*>(data);
+    for (size_t pos = 0; pos < size; pos += compression::BLOCK_SIZE)
+    {
+        const size_t block_size = std::min(compression::BLOCK_SIZE, size - pos);
+        if (buffer_.size() + sizeof(uint32_t) + compression::compress_bound(block_size) > BUFFER_SIZE) flush();
+
+        // Blocks are compressed straight into the write buffer, which can briefly grow past BUFFER_SIZE to fit a whole block.
+        const size_t header_pos = buffer_.size();
+        buffer_.resize(header_pos + sizeof(uint32_t) + compression::compress_bound(block_size));
+        char* const dest = buffer_.data() + header_pos + sizeof(uint32_t);
+        size_t stored_size = compression::compress_block(bytes + pos, block_size, dest);
+        uint32_t header = static_cast<uint32_t>(stored_size) << 1;
+        if (stored_size >= block_size)
+        {
+            std::memcpy(dest, bytes + pos, block_size);
+            stored_size = block_size;
+            header = (static_cast<uint32_t>(block_size) << 1) | 1;
+        }
+        header = fileutils::little_endian(header);
+        std::memcpy(buffer_.data() + header_pos, &header, sizeof(uint32_t));
+        buffer_.resize(header_pos + sizeof(uint32_t) + stored_size);
+    }
+}
+
+// Writes a file header: a magic number from fileutils::fourcc(), then a version.
+void FileWriter::write_header(uint32_t magic, uint32_t schema_version)
+{
+    write_data<uint32_t>(magic);
+    write_varint(schema_version);
+}
+
+// Writes a raw block of binary data to the file, with no size prefix.
+void FileWriter::write_raw(const void* data, size_t size)
+{
+    if (buffer_.size() + size > BUFFER_SIZE) flush();
+    const char* bytes = static_cast<const char*>(data);
+    if (size >= BUFFER_SIZE && !memory_)    // Large blocks skip the buffer entirely, rather than being copied into it first.
+    {
+        file_out_.write(bytes, size);
+        flushed_ += size;
+    }
+    else buffer_.insert(buffer_.end(), bytes, bytes + size);
 }
 
 // Writes a string to the file.
 void FileWriter::write_string(std::string str)
 {
-    uint32_t len = str.size();
-    write_data<uint32_t>(len);
-    file_out_.write(str.c_str(), str.size());
+    write_data<uint32_t>(str.size());
+    write_raw(str.data(), str.size());
 }
 
+// Writes an unsigned integer as an LEB128 varint, taking 1 byte for values below 128.
+void FileWriter::write_varint(uint64_t value)
+{
+    char bytes[10];
+    unsigned int count = 0;
+    do
+    {
+        bytes[count] = static_cast<char>(value & 0x7F);
+        value >>= 7;
+        if (value) bytes[count] |= 0x80;
+        count++;
+    } while (value);
+    write_raw(bytes, count);
+}
+
+// Writes a signed integer as a zigzag-encoded varint, so small negative values stay small too.
+void FileWriter::write_varint_signed(int64_t value) { write_varint((static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63)); }
+
 }   // namespace gorp
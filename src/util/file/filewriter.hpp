@@ -6,25 +6,62 @@
 
 #pragma once
 
+#include <cstring>  // std::memcpy
 #include <fstream>
 
 #include "core/global.hpp"
+#include "util/file/fileutils.hpp"
 
 namespace gorp {
 
+// Everything written is collected in an internal buffer, and only passed on to the file in large blocks, so writing many small fields stays cheap. All
+// fixed-size values are stored little-endian. Files can optionally use a header (a magic number and schema version) and tagged, length-prefixed sections,
+// which FileReader can use to skip anything it doesn't recognize. The same methods can also write into memory, with open_memory() and take_memory().
 class FileWriter {
 public:
-    void    close_file();                           // Closes the binary file.
-    void    open_file(std::string filename);        // Opens a file for writing.
-    void    write_char_vec(std::vector<char> vec);  // Writes binary data (in the form of an std::vector<char>) to the binary file.
-    void    write_string(std::string str);          // Writes a string to the file.
+    static constexpr size_t BUFFER_SIZE =   64 * 1024;  // The size of the write buffer, in bytes.
+
+                FileWriter();                           // Constructor, sets up the write buffer.
+                FileWriter(const FileWriter&) = delete; // No copying, as each FileWriter owns its open file and buffer.
+                ~FileWriter();                          // Destructor, flushes anything still buffered.
+    void        begin_section(uint32_t tag);            // Begins a new section, identified by a tag from fileutils::fourcc(). Sections can be nested.
+    void        close_file();                           // Closes the binary file.
+    void        end_section();                          // Ends the current section, filling in its length.
+    bool        failed() const;                         // Checks if anything written to the file so far has failed, including closing it.
+    void        open_file(std::string filename, bool append = false);   // Opens a file for writing, or for appending to the end of an existing file.
+    void        open_memory();                          // Starts writing into memory instead of a file.
+    void        open_temp_file(const std::string &filename);    // Opens a temporary file to write a new copy of filename into, for replace_file().
+    uint64_t    position() const;                       // The current write position, in bytes from the start of the file.
+    // Closes the temporary file opened by open_temp_file(), syncs it to the disk, and renames it over filename. Throws if anything failed to write.
+    void        replace_file(const std::string &filename);
+    std::string take_memory();                          // Finishes writing into memory, and returns everything that was written.
+    void        write_char_vec(std::vector<char> vec);  // Writes binary data (in the form of an std::vector<char>) to the binary file.
+    void        write_compressed(const void* data, size_t size);    // Writes a block of data compressed in blocks, for FileReader::read_compressed().
+    void        write_header(uint32_t magic, uint32_t schema_version);  // Writes a file header: a magic number from fileutils::fourcc(), then a version.
+    void        write_raw(const void* data, size_t size);   // Writes a raw block of binary data to the file, with no size prefix.
+    void        write_string(std::string str);          // Writes a string to the file.
+    void        write_varint(uint64_t value);           // Writes an unsigned integer as an LEB128 varint, taking 1 byte for values below 128.
+    void        write_varint_signed(int64_t value);     // Writes a signed integer as a zigzag-encoded varint, so small negative values stay small too.
 
     // Writes a basic data type (integer, float, etc.) to the file.
     template<typename T> void   write_data(T data)
-    { file_out_.write(reinterpret_cast<const char*>(&data), sizeof(T)); }
+    {
+        data = fileutils::little_endian(data);
+        if (buffer_.size() + sizeof(T) > BUFFER_SIZE) flush();
+        const size_t pos = buffer_.size();
+        buffer_.resize(pos + sizeof(T));
+        std::memcpy(buffer_.data() + pos, &data, sizeof(T));
+    }
 
 protected:
-    std::ofstream   file_out_;  // File handle for writing into the binary data file.
+    void        flush();    // Writes the buffer out to the file.
+    static std::string  temp_filename(const std::string &filename); // The temporary file used by open_temp_file() and replace_file().
+
+    std::vector<char>       buffer_;    // Data waiting to be written to the file, or everything written so far when writing into memory.
+    std::ofstream           file_out_;  // File handle for writing into the binary data file.
+    uint64_t                flushed_;   // The number of bytes already written out to the file.
+    bool                    memory_;    // Whether we're writing into memory rather than a file.
+    std::vector<uint64_t>   sections_;  // The file offset of the length field of each section that's still open.
 };
 
 }   // namespace gorp
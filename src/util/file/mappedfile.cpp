@@ -0,0 +1,84 @@
+// util/file/mappedfile.cpp -- The MappedFile class provides read-only, memory-mapped access to a file on disk, without copying it into memory.
+
+// SPDX-FileType: SOURCE
+// SPDX-FileCopyrightText: Copyright 2025 Raine Simmons <gc@gravecat.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifdef GORP_TARGET_WINDOWS
+#include <windows.h>
+#else
+#include <fcntl.h>      // open()
+#include <sys/mman.h>   // mmap(), munmap()
+#include <sys/stat.h>   // fstat()
+#include <unistd.h>     // close()
+#endif
+
+#include "util/file/mappedfile.hpp"
+
+namespace gorp {
+
+// Maps a file into memory, read-only.
+MappedFile::MappedFile(const std::string &filename) : data_(nullptr), size_(0)
+#ifdef GORP_TARGET_WINDOWS
+    , mapping_handle_(nullptr)
+#endif
+{
+#ifdef GORP_TARGET_WINDOWS
+    HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) throw std::runtime_error("Cannot open file: " + filename);
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size))
+    {
+        CloseHandle(file);
+        throw std::runtime_error("Cannot determine size of file: " + filename);
+    }
+    size_ = static_cast<size_t>(file_size.QuadPart);
+    if (size_)
+    {
+        mapping_handle_ = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping_handle_) data_ = static_cast<const char*>(MapViewOfFile(mapping_handle_, FILE_MAP_READ, 0, 0, 0));
+    }
+    CloseHandle(file);  // The mapping keeps its own reference to the file.
+    if (size_ && !data_)
+    {
+        if (mapping_handle_) CloseHandle(mapping_handle_);
+        throw std::runtime_error("Cannot map file: " + filename);
+    }
+#else
+    const int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) throw std::runtime_error("Cannot open file: " + filename);
+    struct stat info;
+    if (fstat(fd, &info) != 0)
+    {
+        close(fd);
+        throw std::runtime_error("Cannot determine size of file: " + filename);
+    }
+    size_ = static_cast<size_t>(info.st_size);
+    if (size_)
+    {
+        void* mapped = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped != MAP_FAILED) data_ = static_cast<const char*>(mapped);
+    }
+    close(fd);  // The mapping keeps its own reference to the file.
+    if (size_ && !data_) throw std::runtime_error("Cannot map file: " + filename);
+#endif
+}
+
+// Unmaps the file.
+MappedFile::~MappedFile()
+{
+#ifdef GORP_TARGET_WINDOWS
+    if (data_) UnmapViewOfFile(data_);
+    if (mapping_handle_) CloseHandle(mapping_handle_);
+#else
+    if (data_) munmap(const_cast<char*>(data_), size_);
+#endif
+}
+
+// Returns a pointer to the start of the mapped file.
+const char* MappedFile::data() const { return data_; }
+
+// The size of the mapped file, in bytes.
+size_t MappedFile::size() const { return size_; }
+
+}   // namespace gorp
@@ -0,0 +1,31 @@
+// util/file/mappedfile.hpp -- The MappedFile class provides read-only, memory-mapped access to a file on disk, without copying it into memory.
+
+// SPDX-FileType: SOURCE
+// SPDX-FileCopyrightText: Copyright 2025 Raine Simmons <gc@gravecat.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include "core/global.hpp"
+
+namespace gorp {
+
+class MappedFile {
+public:
+                MappedFile() = delete;  // No default constructor.
+                MappedFile(const std::string &filename);    // Maps a file into memory, read-only.
+                MappedFile(const MappedFile&) = delete;     // No copying; each MappedFile owns its mapping.
+                MappedFile& operator=(const MappedFile&) = delete;
+                ~MappedFile();          // Unmaps the file.
+    const char* data() const;           // Returns a pointer to the start of the mapped file.
+    size_t      size() const;           // The size of the mapped file, in bytes.
+
+private:
+    const char* data_;  // The start of the mapped memory, or nullptr for an empty file.
+    size_t      size_;  // The size of the mapped file, in bytes.
+#ifdef GORP_TARGET_WINDOWS
+    void*       mapping_handle_;    // The Windows file-mapping object handle.
+#endif
+};
+
+}   // namespace gorp
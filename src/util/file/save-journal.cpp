@@ -0,0 +1,355 @@
+// util/file/save-journal.cpp -- Crash-safe save files, made of independent blocks that are written as an append-only journal on a background thread.
+
+// SPDX-FileType: SOURCE
+// SPDX-FileCopyrightText: Copyright 2025 Raine Simmons <gc@gravecat.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "core/core.hpp"
+#include "util/file/binpath.hpp"
+#include "util/file/filereader.hpp"
+#include "util/file/fileutils.hpp"
+#include "util/file/save-journal.hpp"
+#include "util/math/mathutils.hpp"
+
+namespace gorp {
+
+// The file is a header written by FileWriter::write_header(), followed by any number of transactions. Each transaction is one or more BLCK sections
+// and then a CMIT section:
+//
+//  BLCK    varint      transaction number
+//          string      block ID
+//          uint64_t    FNV-1a hash of the uncompressed contents
+//          varint      compressed size, followed by the contents, from FileWriter::write_compressed()
+//  CMIT    varint      transaction number
+//          varint      the number of blocks in the transaction
+//          uint64_t    FNV-1a checksum of every block's ID, content hash and compressed contents, in order
+//
+// Blocks are compressed on the background thread, so the main thread only pays for copying them. The content hash is of the uncompressed contents, so
+// unchanged blocks can be spotted without decompressing anything.
+
+// Opens a save file (relative to the game's path), reading the index of every committed block, or starting an empty save if discard_existing is set.
+// The file doesn't have to exist yet.
+SaveJournal::SaveJournal(const std::string &filename, bool discard_existing) : filename_(filename), garbage_bytes_(0), live_bytes_(0),
+    needs_compact_(discard_existing), next_txn_(1), stopping_(false), writing_(false)
+{
+    // Starting a new save still leaves the old file in place until the first commit, which rewrites it from scratch.
+    if (!discard_existing) scan();
+    for (const auto &[id, ref] : index_)
+        hashes_[id] = ref.hash;
+    thread_ = std::thread(&SaveJournal::worker, this);
+}
+
+// Destructor, finishes writing any pending commit before returning.
+SaveJournal::~SaveJournal()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    work_cv_.notify_all();
+    thread_.join();
+}
+
+// Appends a transaction to the end of the file. Needs the file mutex.
+void SaveJournal::append(const std::map<std::string, std::string> &blocks)
+{
+    std::vector<std::string> storage;
+    BlockList list;
+    pack(blocks, storage, list);
+
+    reader_.reset(nullptr);
+    open_file(filename_, true);
+    if (!position()) write_header(SAVE_MAGIC, SAVE_VERSION);
+    auto written = write_transaction(list);
+    const uint64_t file_end = position();
+    close_file();
+    if (failed())
+    {
+        // Whatever made it into the file can't be trusted to end cleanly, so the next commit has to start over.
+        needs_compact_ = true;
+        throw std::runtime_error("Could not write save file: " + filename_);
+    }
+    fileutils::sync_file(BinPath::game_path(filename_));
+
+    for (auto &[id, ref] : written)
+    {
+        auto it = index_.find(id);
+        if (it != index_.end()) live_bytes_ -= it->second.size;
+        live_bytes_ += ref.size;
+        index_[id] = ref;
+    }
+    garbage_bytes_ = file_end - live_bytes_;
+}
+
+// Lists every block whose ID starts with the specified prefix.
+std::vector<std::string> SaveJournal::block_ids(const std::string &prefix) const
+{
+    std::vector<std::string> ids;
+    for (auto it = hashes_.lower_bound(prefix); it != hashes_.end() && !it->first.compare(0, prefix.size(), prefix); ++it)
+        ids.push_back(it->first);
+    return ids;
+}
+
+// Checks if a commit is still waiting to be written.
+bool SaveJournal::busy() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return writing_ || pending_.size();
+}
+
+// Queues every staged block to be written on the background thread, as a single transaction.
+void SaveJournal::commit()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (staged_.empty() && failed_.empty()) return;
+
+        // If the previous commit hasn't been written yet, the two are merged, so a slow disk never builds up a backlog of stale snapshots.
+        for (auto &[id, contents] : staged_)
+            pending_[id] = std::move(contents);
+        for (auto &[id, contents] : failed_)
+            pending_.emplace(id, std::move(contents));
+        failed_.clear();
+    }
+    staged_.clear();
+    work_cv_.notify_all();
+}
+
+// Rewrites the file with only the latest copy of each block. Needs the file mutex.
+void SaveJournal::compact(const std::map<std::string, std::string> &blocks)
+{
+    // Every block is copied straight from the old file's mapping into the new one, still compressed.
+    FileReader &old_file = reader();
+    BlockList list;
+    for (const auto &[id, ref] : index_)
+    {
+        if (blocks.count(id)) continue;
+        old_file.seek(ref.offset);
+        list.push_back({ id, old_file.read_view(ref.size), ref.hash });
+    }
+    std::vector<std::string> storage;
+    pack(blocks, storage, list);
+
+    open_temp_file(filename_);
+    write_header(SAVE_MAGIC, SAVE_VERSION);
+    auto written = write_transaction(list);
+    const uint64_t file_end = position();
+    reader_.reset(nullptr);
+    replace_file(filename_);
+
+    index_ = std::move(written);
+    live_bytes_ = 0;
+    for (const auto &[id, ref] : index_)
+        live_bytes_ += ref.size;
+    garbage_bytes_ = file_end - live_bytes_;
+    needs_compact_ = false;
+}
+
+// Checks if a block exists in the save.
+bool SaveJournal::has_block(const std::string &id) const { return hashes_.count(id); }
+
+// Compresses blocks to be written, adding them to a BlockList. The compressed contents are kept in storage, which must outlive the list.
+void SaveJournal::pack(const std::map<std::string, std::string> &blocks, std::vector<std::string> &storage, BlockList &list)
+{
+    storage.reserve(storage.size() + blocks.size()); // The list points into storage, so it mustn't be reallocated.
+    for (const auto &[id, contents] : blocks)
+    {
+        FileWriter packer;
+        packer.open_memory();
+        packer.write_compressed(contents.data(), contents.size());
+        storage.push_back(packer.take_memory());
+        list.push_back({ id, storage.back(), mathutils::fnv1a(contents.data(), contents.size()) });
+    }
+}
+
+// Reads the contents of a block, waiting for any pending commit to be written first.
+std::string SaveJournal::read_block(const std::string &id)
+{
+    auto staged = staged_.find(id);
+    if (staged != staged_.end()) return staged->second;
+    wait();
+
+    std::lock_guard<std::mutex> lock(file_mutex_);
+    auto it = index_.find(id);
+    if (it == index_.end()) throw std::runtime_error("Missing save block: " + id);
+    FileReader &file = reader();
+    file.seek(it->second.offset);
+    const std::string_view packed = file.read_view(it->second.size);
+
+    // The compressed data starts with its uncompressed size. Nothing compresses much better than 255 to 1, so anything claiming more is corrupt.
+    FileReader block(packed.data(), packed.size());
+    const uint64_t size = block.read_varint();
+    if (size > packed.size() * 256) throw std::runtime_error("Invalid save block: " + id);
+    block.seek(0);
+    std::string contents(size, '\0');
+    block.read_compressed(contents.data(), contents.size());
+    return contents;
+}
+
+// The save file, mapped for reading. The mapping is kept until the file is next written, so loading a save maps it only once, however many blocks are
+// read. Needs the file mutex.
+FileReader& SaveJournal::reader()
+{
+    if (!reader_) reader_ = std::make_unique<FileReader>(BinPath::game_path(filename_), true);
+    return *reader_;
+}
+
+// Reads the file, indexing every block from each intact transaction.
+void SaveJournal::scan()
+{
+    FileReader &file = reader();
+    if (!file.file_size()) return;
+    uint32_t version = 0;
+    try { version = file.read_header(SAVE_MAGIC); }
+    catch (const std::exception&) { throw GuruMeditation("Invalid save file: " + filename_); }
+    if (version != SAVE_VERSION) throw GuruMeditation("Save file version mismatch: " + filename_, version, SAVE_VERSION);
+
+    // Blocks are only added to the index once the commit record for their transaction has been read and checked. Anything after the last intact
+    // transaction is what was being written when the game last stopped, and is thrown away.
+    std::vector<std::pair<std::string, BlockRef>> txn_blocks;
+    uint64_t txn = 0, checksum = mathutils::FNV1A_OFFSET_BASIS, committed_end = file.position();
+    try
+    {
+        uint32_t tag;
+        size_t length;
+        while (file.read_section(tag, length))
+        {
+            const size_t section_end = file.position() + length;
+            if (tag == SECTION_BLOCK)
+            {
+                const uint64_t block_txn = file.read_varint();
+                if (txn_blocks.size() && block_txn != txn) break;
+                txn = block_txn;
+                std::string id(file.read_string_view());
+                const uint64_t hash = file.read_data<uint64_t>();
+                const uint64_t size = file.read_varint();
+                const uint64_t offset = file.position();
+                const std::string_view packed = file.read_view(size);
+                checksum = mathutils::fnv1a(packed.data(), packed.size(), mathutils::fnv1a_value(hash, mathutils::fnv1a(id.data(), id.size(), checksum)));
+                txn_blocks.push_back({ std::move(id), { hash, offset, size } });
+            }
+            else if (tag == SECTION_COMMIT)
+            {
+                const uint64_t commit_txn = file.read_varint();
+                const uint64_t block_count = file.read_varint();
+                if (txn_blocks.empty() || commit_txn != txn || block_count != txn_blocks.size() || file.read_data<uint64_t>() != checksum) break;
+                for (auto &[id, ref] : txn_blocks)
+                {
+                    auto it = index_.find(id);
+                    if (it != index_.end()) live_bytes_ -= it->second.size;
+                    live_bytes_ += ref.size;
+                    index_[id] = ref;
+                }
+                txn_blocks.clear();
+                checksum = mathutils::FNV1A_OFFSET_BASIS;
+                next_txn_ = txn + 1;
+                committed_end = section_end;
+            }
+            else file.skip(length);
+            if (file.position() != section_end) break;
+        }
+    }
+    catch (const std::exception&) { }   // A truncated section just means the last transaction never finished.
+
+    garbage_bytes_ = committed_end - live_bytes_;
+    if (committed_end != file.file_size())
+    {
+        core().log("Discarding incomplete transaction at the end of save file " + filename_ + ".", Core::CORE_WARN);
+        needs_compact_ = true;
+    }
+}
+
+// Stages a snapshot of a block for the next commit. Unchanged blocks are dropped.
+void SaveJournal::stage_block(const std::string &id, std::string data)
+{
+    const uint64_t hash = mathutils::fnv1a(data.data(), data.size());
+    auto it = hashes_.find(id);
+    if (it != hashes_.end() && it->second == hash) return;
+    hashes_[id] = hash;
+    staged_[id] = std::move(data);
+}
+
+// Reports any errors from the background thread, returning false if there were any. Call this once per turn.
+bool SaveJournal::update()
+{
+    std::vector<std::string> errors;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        errors.swap(errors_);
+    }
+    for (const auto &error : errors)
+        core().nonfatal(error, Core::CORE_WARN);
+    return errors.empty();
+}
+
+// Blocks until any pending commit has been written.
+void SaveJournal::wait()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    idle_cv_.wait(lock, [this] { return !writing_ && pending_.empty(); });
+}
+
+// The background thread loop, writing each commit until the SaveJournal is destroyed.
+void SaveJournal::worker()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true)
+    {
+        work_cv_.wait(lock, [this] { return stopping_ || pending_.size(); });
+        if (pending_.empty()) return;   // Anything still pending is written before stopping.
+        std::map<std::string, std::string> blocks;
+        blocks.swap(pending_);
+        writing_ = true;
+        lock.unlock();
+
+        std::string error;
+        try
+        {
+            std::lock_guard<std::mutex> file_lock(file_mutex_);
+            if (needs_compact_ || (garbage_bytes_ > live_bytes_ && garbage_bytes_ > COMPACT_MIN_BYTES)) compact(blocks);
+            else append(blocks);
+        }
+        catch (const std::exception &e) { error = e.what(); }
+
+        lock.lock();
+        if (error.size())
+        {
+            // Keep the blocks to try again with the next commit, unless that commit already has newer copies of them.
+            errors_.push_back("Could not save the game: " + error);
+            for (auto &[id, contents] : blocks)
+                failed_.emplace(id, std::move(contents));
+        }
+        writing_ = false;
+        idle_cv_.notify_all();
+    }
+}
+
+// Writes a transaction at the end of the open file, returning its index.
+std::map<std::string, SaveJournal::BlockRef> SaveJournal::write_transaction(const BlockList &blocks)
+{
+    std::map<std::string, BlockRef> written;
+    uint64_t checksum = mathutils::FNV1A_OFFSET_BASIS;
+    for (const auto &block : blocks)
+    {
+        begin_section(SECTION_BLOCK);
+        write_varint(next_txn_);
+        write_string(std::string(block.id));
+        write_data<uint64_t>(block.hash);
+        write_varint(block.packed.size());
+        const uint64_t offset = position();
+        write_raw(block.packed.data(), block.packed.size());
+        end_section();
+
+        checksum = mathutils::fnv1a(block.packed.data(), block.packed.size(),
+            mathutils::fnv1a_value(block.hash, mathutils::fnv1a(block.id.data(), block.id.size(), checksum)));
+        written[std::string(block.id)] = { block.hash, offset, block.packed.size() };
+    }
+    begin_section(SECTION_COMMIT);
+    write_varint(next_txn_++);
+    write_varint(blocks.size());
+    write_data<uint64_t>(checksum);
+    end_section();
+    return written;
+}
+
+}   // namespace gorp
@@ -0,0 +1,103 @@
+// util/file/save-journal.hpp -- Crash-safe save files, made of independent blocks that are written as an append-only journal on a background thread.
+
+// SPDX-FileType: SOURCE
+// SPDX-FileCopyrightText: Copyright 2025 Raine Simmons <gc@gravecat.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "core/global.hpp"
+#include "util/file/filewriter.hpp"
+
+namespace gorp {
+
+class FileReader;   // defined in util/file/filereader.hpp
+
+// A save file is a set of named blocks (world chunks, the message log, and so on), each one an opaque snapshot that can be replaced without touching the
+// others. Blocks are staged on the main thread, and commit() hands them to a background thread, which appends them to the end of the file followed by a
+// commit record. When the file is loaded, blocks only count once their commit record has been read and its checksum matches, so a crash part-way
+// through writing just loses that one commit, never the save. Each commit is synced to the disk before it counts as written, so this holds for a power
+// cut or OS crash too, as long as the disk honours the sync. Older copies of replaced blocks pile up at the start of the file, so once there's more
+// garbage than live data, the next commit rewrites the whole file to a temporary file instead, and renames it into place.
+//
+// Only one thread should stage and commit blocks; the background thread is the only one that writes to the file.
+class SaveJournal : public FileWriter {
+public:
+    static constexpr uint64_t   COMPACT_MIN_BYTES = 1024 * 1024;    // Journals with less garbage than this are never compacted.
+    static constexpr uint32_t   SAVE_MAGIC =    fileutils::fourcc("GSAV");  // Identifies a save file.
+    static constexpr uint32_t   SAVE_VERSION =  2;  // The version changes when save files are no longer compatible.
+    static constexpr uint32_t   SECTION_BLOCK = fileutils::fourcc("BLCK");  // A block's contents, as part of a transaction.
+    static constexpr uint32_t   SECTION_COMMIT =    fileutils::fourcc("CMIT");  // Ends a transaction, making its blocks part of the save.
+
+                SaveJournal() = delete; // No default constructor.
+                // Opens a save file (relative to the game's path), reading the index of every committed block, or starting an empty save if
+                // discard_existing is set. The file doesn't have to exist yet.
+                SaveJournal(const std::string &filename, bool discard_existing = false);
+                SaveJournal(const SaveJournal&) = delete;   // No copying, as the background thread holds a pointer to this SaveJournal.
+                ~SaveJournal();         // Destructor, finishes writing any pending commit before returning.
+    std::vector<std::string>    block_ids(const std::string &prefix) const; // Lists every block whose ID starts with the specified prefix.
+    bool        busy() const;           // Checks if a commit is still waiting to be written.
+    void        commit();               // Queues every staged block to be written on the background thread, as a single transaction.
+    bool        has_block(const std::string &id) const; // Checks if a block exists in the save.
+    std::string read_block(const std::string &id);      // Reads the contents of a block, waiting for any pending commit to be written first.
+    void        stage_block(const std::string &id, std::string data);   // Stages a snapshot of a block for the next commit. Unchanged blocks are dropped.
+    bool        update();               // Reports any errors from the background thread, returning false if there were any. Call this once per turn.
+    void        wait();                 // Blocks until any pending commit has been written.
+
+private:
+    // Where the latest committed copy of a block lives in the file.
+    struct BlockRef
+    {
+        uint64_t    hash;       // FNV-1a hash of the block's uncompressed contents.
+        uint64_t    offset;     // The file offset of the compressed contents.
+        uint64_t    size;       // The size of the compressed contents, in bytes.
+    };
+
+    // A block ready to be written.
+    struct PackedBlock
+    {
+        std::string_view    id;         // The block's ID.
+        std::string_view    packed;     // The block's compressed contents.
+        uint64_t            hash;       // FNV-1a hash of the block's uncompressed contents.
+    };
+
+    using BlockList = std::vector<PackedBlock>; // Blocks in the order they're written.
+
+    void    append(const std::map<std::string, std::string> &blocks);   // Appends a transaction to the end of the file. Needs the file mutex.
+    void    compact(const std::map<std::string, std::string> &blocks);  // Rewrites the file with only the latest copy of each block. Needs the file mutex.
+    // Compresses blocks to be written, adding them to a BlockList. The compressed contents are kept in storage, which must outlive the list.
+    static void pack(const std::map<std::string, std::string> &blocks, std::vector<std::string> &storage, BlockList &list);
+    FileReader& reader();   // The save file, mapped for reading. The mapping is kept until the file is next written. Needs the file mutex.
+    void    scan();     // Reads the file, indexing every block from each intact transaction.
+    void    worker();   // The background thread loop, writing each commit until the SaveJournal is destroyed.
+    std::map<std::string, BlockRef> write_transaction(const BlockList &blocks); // Writes a transaction at the end of the open file, returning its index.
+
+    std::vector<std::string>    errors_;    // Errors from the background thread, waiting to be reported on the main thread.
+    std::map<std::string, std::string>  failed_;    // Blocks from a commit that couldn't be written, to try again with the next commit.
+    mutable std::mutex          file_mutex_;    // Guards the file itself, and the index and counters describing it.
+    std::string                 filename_;  // The save file, relative to the game's path.
+    uint64_t                    garbage_bytes_; // The number of bytes in the file taken up by replaced blocks and broken transactions.
+    std::map<std::string, uint64_t> hashes_;    // The hash of the latest snapshot of each block, staged or committed, to spot unchanged blocks.
+    std::map<std::string, BlockRef> index_;     // Every committed block in the file.
+    std::condition_variable     idle_cv_;   // Signalled whenever the background thread finishes writing a commit.
+    uint64_t                    live_bytes_;    // The number of bytes in the file taken up by the latest copy of each block.
+    mutable std::mutex          mutex_;     // Guards everything that the background thread shares with the main thread, except the file itself.
+    bool                        needs_compact_; // Set when the file has to be rewritten before anything more can be appended, such as after a crash.
+    uint64_t                    next_txn_;  // The number of the next transaction to be written.
+    std::map<std::string, std::string>  pending_;   // Blocks committed on the main thread, waiting for the background thread.
+    std::unique_ptr<FileReader> reader_;    // The save file, mapped for reading, or nullptr if it isn't mapped right now. Guarded by the file mutex.
+    std::map<std::string, std::string>  staged_;    // Blocks staged for the next commit.
+    bool                        stopping_;  // Set when the SaveJournal is being destroyed, to stop the background thread.
+    std::thread                 thread_;    // The background thread.
+    bool                        writing_;   // Set while the background thread is writing a commit.
+    std::condition_variable     work_cv_;   // Signalled whenever blocks are committed, or the SaveJournal is being destroyed.
+};
+
+}   // namespace gorp
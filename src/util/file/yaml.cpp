@@ -4,34 +4,33 @@
 // SPDX-FileCopyrightText: Copyright 2025 Raine Simmons <gc@gravecat.com>
 // SPDX-License-Identifier: GPL-3.0-or-later
 
-#include "util/file/fileutils.hpp"
+#include <algorithm>
+#include <fstream>
+
 #include "util/file/yaml.hpp"
 
 namespace gorp {
 
 // Blank constructor.
-YAML::YAML() : ref_(nullptr) { }
+YAML::YAML() : doc_(nullptr), ref_(nullptr) { }
 
 // Calls load_file() when constructing.
 YAML::YAML(const std::string& filename, bool allow_backslash) { load_file(filename, allow_backslash); }
 
-// Creates a new YAML object from a parent tree.
-YAML::YAML(const ryml::Tree tree, ryml::ConstNodeRef new_ref) : ref_(new_ref), tree_(tree) { }
+// Creates a new view into an existing document.
+YAML::YAML(std::shared_ptr<const Document> doc, ryml::ConstNodeRef new_ref) : doc_(doc), ref_(new_ref) { }
 
-// Retrieves a value from a sequence, as a string.
-std::string YAML::get(int index) const
+// Retrieves a value from a sequence.
+std::string_view YAML::get(int index) const
 {
     if (!is_seq()) throw std::runtime_error("Not a sequence!");
     if (index < 0 || index >= size()) throw std::runtime_error("Invalid sequence index!");
-    return std::string(noderef()[index].val().str).substr(0, noderef()[index].val().len);
+    const ryml::csubstr value = noderef()[index].val();
+    return std::string_view(value.str, value.len);
 }
 
 // Retrieves a child of this tree.
-YAML YAML::get_child(const std::string& key) const
-{
-    YAML new_yaml(tree_, ref_[ryml::to_csubstr(key)]);
-    return new_yaml;
-}
+YAML YAML::get_child(const std::string& key) const { return YAML(doc_, ref_[ryml::to_csubstr(key)]); }
 
 // Retrieves all values of a sequence.
 std::vector<std::string> YAML::get_seq(const std::string &key) const
@@ -41,7 +40,7 @@ std::vector<std::string> YAML::get_seq(const std::string &key) const
     if (!yaml.is_seq()) throw GuruMeditation("Invalid YAML key (not a sequence): " + key);
     std::vector<std::string> vec(yaml.size());
     for (int i = 0; i < yaml.size(); i++)
-        vec.at(i) = yaml.get(i);
+        vec.at(i) = std::string(yaml.get(i));
     return vec;
 }
 
@@ -59,13 +58,14 @@ bool YAML::key_exists(const std::string& key) const
 }
 
 // Retrieves the key values of a map.
-std::vector<std::string> YAML::keys() const
+std::vector<std::string_view> YAML::keys() const
 {
     if (!is_map()) throw std::runtime_error("Not a map!");
     ryml::ConstNodeRef::children_view children = noderef().children();
-    std::vector<std::string> vec_out;
+    std::vector<std::string_view> vec_out;
+    vec_out.reserve(noderef().num_children());
     for (auto child : children)
-        vec_out.push_back(std::string(child.key().str).substr(0, child.key().len));
+        vec_out.emplace_back(child.key().str, child.key().len);
     return vec_out;
 }
 
@@ -77,10 +77,8 @@ std::map<std::string, std::string> YAML::keys_vals() const
     std::map<std::string, std::string> map_out;
     for (auto child : children)
     {
-        std::string key_str = (std::string(child.key().str).substr(0, child.key().len));
         if (!child.has_val()) throw std::runtime_error("No values!");
-        std::string val_str = (std::string(child.val().str).substr(0, child.val().len));
-        map_out.insert(std::pair<std::string, std::string>(key_str, val_str));
+        map_out.emplace(std::string(child.key().str, child.key().len), std::string(child.val().str, child.val().len));
     }
     return map_out;
 }
@@ -88,36 +86,58 @@ std::map<std::string, std::string> YAML::keys_vals() const
 // Loads a YAML file into memory and parse it.
 void YAML::load_file(const std::string& filename, bool allow_backslash)
 {
-    if (!fileutils::file_exists(filename)) throw std::runtime_error("Invalid file: " + filename);
-    std::string file_string = fileutils::file_to_string(filename.c_str());
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) throw std::runtime_error("Invalid file: " + filename);
+    const size_t file_size = file.tellg();
+    file.seekg(0);
+    std::string data(file_size, '\0');
+    if (!file.read(data.data(), file_size)) throw std::runtime_error("Could not read file: " + filename);
+    file.close();
+    load_string(std::move(data), filename, allow_backslash);
+}
+
+// Parses YAML data that's already in memory, taking ownership of it. The name is only used in error messages.
+void YAML::load_string(std::string data, const std::string& name, bool allow_backslash)
+{
+    // The data is moved into a buffer we own, and parsed in place, so it's never copied again; the tree's strings all point into it.
+    auto doc = std::make_shared<Document>();
+    doc->buffer = std::move(data);
+
     // If we don't care about using backslash for... whatever rapidYAML does with them, just turn them into double-backslashes so they're treated as a
-    // string literal of \ instead of... I don't know, it's probably used for writing hex or octal or some shit.
+    // string literal of \ instead of... I don't know, it's probably used for writing hex or octal or some shit. The buffer is grown once, then filled in
+    // from the back, so every character is moved exactly once.
     if (!allow_backslash)
     {
-        for (unsigned int i = 0; i < file_string.size(); i++)
+        std::string &buffer = doc->buffer;
+        const size_t data_size = buffer.size();
+        const size_t backslashes = std::count(buffer.begin(), buffer.end(), '\\');
+        if (backslashes)
         {
-            if (file_string[i] == '\\')
+            buffer.resize(data_size + backslashes);
+            size_t out = buffer.size();
+            for (size_t in = data_size; in-- > 0;)
             {
-                file_string = file_string.substr(0, i) + '\\' + file_string.substr(i);
-                i++;
+                buffer[--out] = buffer[in];
+                if (buffer[in] == '\\') buffer[--out] = '\\';
             }
         }
     }
-    tree_ = ryml::parse_in_arena(ryml::to_csubstr(file_string));
-    ref_ = tree_.rootref();
+    doc->tree = ryml::parse_in_place(ryml::to_csubstr(name), ryml::to_substr(doc->buffer));
+    ref_ = doc->tree.rootref();
+    doc_ = doc;
 }
 
-// Returns the noderef for the loaded tree.
+// Returns the noderef for this part of the tree.
 ryml::ConstNodeRef YAML::noderef() const { return ref_; }
 
 // Checks the number of children on the noderef.
 int YAML::size() const { return noderef().num_children(); }
 
-// Returns the value of a key, as a string.
-std::string YAML::val(const std::string& key) const
+// Returns the value of a key.
+std::string_view YAML::val(const std::string& key) const
 {
-    auto cskey = ryml::to_csubstr(key);
-    return std::string(noderef()[cskey].val().str).substr(0, noderef()[cskey].val().len);
+    const ryml::csubstr value = noderef()[ryml::to_csubstr(key)].val();
+    return std::string_view(value.str, value.len);
 }
 
 }   // namespace westgate
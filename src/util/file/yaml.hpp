@@ -7,36 +7,46 @@
 #pragma once
 
 #include <map>
+#include <string_view>
 
 #include "3rdparty/rapidyaml/rapidyaml-0.9.0.hpp"
 #include "core/global.hpp"
 
 namespace gorp {
 
+// Every YAML object made from the same file shares a single parsed document, so children are just lightweight views into it. The string views returned by
+// get(), keys() and val() point into the document, and stay valid for as long as any YAML object made from it still exists.
 class YAML {
 public:
                     YAML();                                     // Blank constructor.
                     YAML(const std::string& filename, bool allow_backslash = false);    // Calls load_file() when constructing.
-    std::string     get(int index) const;                       // Retrieves a value from a sequence, as a string.
+    std::string_view    get(int index) const;                   // Retrieves a value from a sequence.
     YAML            get_child(const std::string& key) const;    // Retrieves a child noderef of this tree.
     std::vector<std::string>    get_seq(const std::string &key) const;  // Retrieves all values of a sequence.
     bool            is_map() const;                             // Checks if the noderef points to a valid map.
     bool            is_seq() const;                             // Checks if the noderef points to a valid sequence.
     bool            key_exists(const std::string& key) const;   // Checks if a given key exists.
-    std::vector<std::string>    keys() const;                   // Retrieves the key values of a map.
+    std::vector<std::string_view>   keys() const;               // Retrieves the key values of a map.
     std::map<std::string, std::string>  keys_vals() const;      // Retrieves the key/value pairs of a map.
     void            load_file(const std::string& filename, bool allow_backslash = false);   // Loads a YAML file into memory and parse it.
+    // Parses YAML data that's already in memory, taking ownership of it. The name is only used in error messages.
+    void            load_string(std::string data, const std::string& name, bool allow_backslash = false);
     int             size() const;                               // Checks the number of children on the noderef.
-    std::string     val(const std::string& key) const;          // Returns the value of a key, as a string.
-
-protected:
-                    YAML(const ryml::Tree tree, ryml::ConstNodeRef new_ref);    // Creates a new YAML object from a parent tree.
+    std::string_view    val(const std::string& key) const;      // Returns the value of a key.
 
 private:
-    ryml::ConstNodeRef  noderef() const;    // Returns the noderef for the loaded tree.
+    // A parsed file. The tree is parsed in place, so its strings all point into the buffer.
+    struct Document
+    {
+        std::string buffer; // The file's contents.
+        ryml::Tree  tree;   // The parsed YAML data.
+    };
+
+                    YAML(std::shared_ptr<const Document> doc, ryml::ConstNodeRef new_ref);  // Creates a new view into an existing document.
+    ryml::ConstNodeRef  noderef() const;    // Returns the noderef for this part of the tree.
 
+    std::shared_ptr<const Document> doc_;   // The parsed document, shared by every YAML object made from it.
     ryml::ConstNodeRef  ref_;   // The NodeRef for this part of the tree.
-    ryml::Tree          tree_;  // The parsed YAML data.
 };
 
 }   // namespace westgate
@@ -0,0 +1,52 @@
+// util/math/bucket-queue.hpp -- A monotone bucketed priority queue of integer items, for flood fills and Dijkstra-style searches over grids.
+
+// SPDX-FileType: SOURCE
+// SPDX-FileCopyrightText: Copyright 2025 Raine Simmons <gc@gravecat.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include "core/global.hpp"
+
+namespace gorp {
+
+// Items are small integers (such as tile indexes) and priorities are bucket numbers, lowest first. Items in the same bucket come out in FIFO order. The
+// queue is monotone: pushing to a bucket lower than the one last popped from puts the item in the current bucket instead. Each bucket is an intrusive
+// linked list, so pushing and popping never allocate, and a full pass over n items and b buckets costs O(n + b).
+class BucketQueue {
+public:
+    static constexpr uint32_t   NONE =  UINT32_MAX; // Marks the end of a bucket's list.
+
+                BucketQueue(uint32_t buckets, uint32_t max_items) : current_(0), head_(buckets, NONE), next_(max_items, NONE), size_(0),
+                    tail_(buckets, NONE) { }
+    uint32_t    current_bucket() const { return current_; }    // The bucket the last item was popped from.
+    bool        empty() const { return !size_; }    // Checks if the queue is empty.
+    uint32_t    pop()   // Removes and returns the next item. The queue must not be empty.
+    {
+        while (head_[current_] == NONE) current_++;
+        const uint32_t item = head_[current_];
+        head_[current_] = next_[item];
+        if (head_[current_] == NONE) tail_[current_] = NONE;
+        size_--;
+        return item;
+    }
+    void        push(uint32_t item, uint32_t bucket)  // Adds an item to the queue. Each item may only be in the queue once at a time.
+    {
+        if (bucket < current_) bucket = current_;
+        else if (bucket >= head_.size()) bucket = head_.size() - 1;
+        next_[item] = NONE;
+        if (tail_[bucket] == NONE) head_[bucket] = item;
+        else next_[tail_[bucket]] = item;
+        tail_[bucket] = item;
+        size_++;
+    }
+
+private:
+    uint32_t                current_;   // The lowest bucket that may still contain items.
+    std::vector<uint32_t>   head_;      // The first item in each bucket.
+    std::vector<uint32_t>   next_;      // The next item after each item in its bucket.
+    uint32_t                size_;      // The number of items in the queue.
+    std::vector<uint32_t>   tail_;      // The last item in each bucket.
+};
+
+}   // namespace gorp
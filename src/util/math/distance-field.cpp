@@ -0,0 +1,73 @@
+// util/math/distance-field.cpp -- Exact Euclidean distance transforms over 2D grids, in linear time (Felzenszwalb & Huttenlocher).
+
+// SPDX-FileType: SOURCE
+// SPDX-FileCopyrightText: Copyright 2025 Raine Simmons <gc@gravecat.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "util/math/distance-field.hpp"
+
+namespace gorp {
+namespace distancefield {
+
+// Computes the 1D squared distance transform of f into d, as the lower envelope of parabolas rooted at each sample. v and z are scratch space, of at
+// least n and n + 1 elements respectively.
+static void edt_1d(const float* f, float* d, uint32_t n, uint32_t* v, float* z)
+{
+    uint32_t k = 0;
+    v[0] = 0;
+    z[0] = -std::numeric_limits<float>::infinity();
+    z[1] = std::numeric_limits<float>::infinity();
+    for (uint32_t q = 1; q < n; q++)
+    {
+        const float fq = f[q] + static_cast<float>(q) * q;
+        float s = (fq - (f[v[k]] + static_cast<float>(v[k]) * v[k])) / (2.0f * q - 2.0f * v[k]);
+        while (s <= z[k])
+        {
+            k--;
+            s = (fq - (f[v[k]] + static_cast<float>(v[k]) * v[k])) / (2.0f * q - 2.0f * v[k]);
+        }
+        k++;
+        v[k] = q;
+        z[k] = s;
+        z[k + 1] = std::numeric_limits<float>::infinity();
+    }
+
+    k = 0;
+    for (uint32_t q = 0; q < n; q++)
+    {
+        while (z[k + 1] < q) k++;
+        const float dq = static_cast<float>(q) - v[k];
+        d[q] = (dq * dq) + f[v[k]];
+    }
+}
+
+// Transforms a grid in place into squared Euclidean distances.
+void squared_edt(Grid2D<float> &grid)
+{
+    const uint32_t width = grid.width(), height = grid.height();
+    const uint32_t longest = std::max(width, height);
+    if (!longest) return;
+    std::vector<float> f(longest), d(longest), z(longest + 1);
+    std::vector<uint32_t> v(longest);
+
+    // Columns first, copying each one out so the 1D pass works on contiguous memory.
+    for (uint32_t x = 0; x < width; x++)
+    {
+        for (uint32_t y = 0; y < height; y++)
+            f[y] = grid(x, y);
+        edt_1d(f.data(), d.data(), height, v.data(), z.data());
+        for (uint32_t y = 0; y < height; y++)
+            grid(x, y) = d[y];
+    }
+
+    // Then rows, which are already contiguous.
+    for (uint32_t y = 0; y < height; y++)
+    {
+        float* row = grid.row_data(y);
+        std::copy(row, row + width, f.begin());
+        edt_1d(f.data(), row, width, v.data(), z.data());
+    }
+}
+
+}   // namespace distancefield
+}   // namespace gorp
@@ -0,0 +1,47 @@
+// util/math/distance-field.hpp -- Exact Euclidean distance transforms over 2D grids, in linear time (Felzenszwalb & Huttenlocher).
+
+// SPDX-FileType: SOURCE
+// SPDX-FileCopyrightText: Copyright 2025 Raine Simmons <gc@gravecat.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <cmath>
+#include <limits>
+
+#include "core/global.hpp"
+#include "util/math/grid2d.hpp"
+
+namespace gorp {
+namespace distancefield {
+
+constexpr float FAR =   1e20f;  // Marks tiles with no known distance in squared_edt(). Large but finite, so the transform's arithmetic never produces NaN.
+
+// Transforms a grid in place into squared Euclidean distances. On input, feature tiles must be 0 and every other tile must be FAR. On output, each tile
+// holds the squared distance to the nearest feature tile, or FAR (or thereabouts) if the grid has no features at all.
+void    squared_edt(Grid2D<float> &grid);
+
+// Returns the Euclidean distance from every tile to the nearest tile for which is_feature(value) is true. Feature tiles themselves are 0, and if there are
+// no feature tiles at all, every tile is infinity.
+template<typename T, typename Pred> Grid2D<float> distance_to(const Grid2D<T> &src, Pred is_feature)
+{
+    Grid2D<float> result(src.size());
+    for (uint32_t y = 0; y < src.height(); y++)
+    {
+        const T* src_row = src.row_data(y);
+        float* row = result.row_data(y);
+        for (uint32_t x = 0; x < src.width(); x++)
+            row[x] = is_feature(src_row[x]) ? 0.0f : FAR;
+    }
+    squared_edt(result);
+    for (uint32_t y = 0; y < result.height(); y++)
+    {
+        float* row = result.row_data(y);
+        for (uint32_t x = 0; x < result.width(); x++)
+            row[x] = (row[x] >= FAR * 0.5f ? std::numeric_limits<float>::infinity() : std::sqrt(row[x]));
+    }
+    return result;
+}
+
+}   // namespace distancefield
+}   // namespace gorp
@@ -0,0 +1,167 @@
+// util/math/grid2d.hpp -- A generic 2D grid container, with unchecked row iteration and neighbourhood access, and a selectable storage layout.
+
+// SPDX-FileType: SOURCE
+// SPDX-FileCopyrightText: Copyright 2025 Raine Simmons <gc@gravecat.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <algorithm>
+#include <iterator>
+
+#include "core/global.hpp"
+
+namespace gorp {
+
+// How a Grid2D lays out its tiles in memory.
+enum class GridLayout : uint8_t {
+    ROW_MAJOR,  // Plain rows, one after another. Rows can be accessed as raw pointers, and the grid can be passed to stencil:: kernels.
+    TILED       // 8x8 tiles, stored in row-major order, with Morton (Z-order) inside each tile. Keeps 2D neighbours close together in memory.
+};
+
+// Which neighbours Grid2D::for_each_neighbour() visits.
+enum class GridNeighbours : uint8_t { ORTHOGONAL, ALL };
+
+template<typename T, GridLayout L = GridLayout::ROW_MAJOR> class Grid2D {
+public:
+    static constexpr uint32_t   TILE_SHIFT =    3;                      // Tiles are 2^3 = 8 tiles wide and high.
+    static constexpr uint32_t   TILE_SIZE =     1 << TILE_SHIFT;        // The width and height of a tile, in the TILED layout.
+    static constexpr uint32_t   TILE_MASK =     TILE_SIZE - 1;          // Masks a coordinate to its position within a tile.
+    static constexpr uint32_t   TILE_AREA =     TILE_SIZE * TILE_SIZE;  // The number of elements in each tile.
+
+    // Walks along a single row of the grid, without bounds checks.
+    template<typename V, typename P> class RowIterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = V*;
+        using reference = V&;
+
+                    RowIterator(P grid, uint32_t x, uint32_t y) : grid_(grid), x_(x), y_(y) { }
+        reference   operator*() const { return grid_->data_[grid_->index(x_, y_)]; }
+        RowIterator& operator++() { x_++; return *this; }
+        bool        operator==(const RowIterator &other) const { return x_ == other.x_; }
+        bool        operator!=(const RowIterator &other) const { return x_ != other.x_; }
+        uint32_t    x() const { return x_; }    // The X coordinate this iterator currently points to.
+
+    private:
+        P           grid_;  // The grid being iterated over.
+        uint32_t    x_, y_; // The current coordinates.
+    };
+
+    // A range covering a single row of the grid, for use in range-based for loops.
+    template<typename V, typename P> class Row {
+    public:
+                    Row(P grid, uint32_t y) : grid_(grid), y_(y) { }
+        RowIterator<V, P>   begin() const { return RowIterator<V, P>(grid_, 0, y_); }
+        RowIterator<V, P>   end() const { return RowIterator<V, P>(grid_, grid_->width_, y_); }
+
+    private:
+        P           grid_;  // The grid this row belongs to.
+        uint32_t    y_;     // The Y coordinate of this row.
+    };
+
+    // An unchecked view of the 3x3 neighbourhood around a tile. The centre tile must not be on the edge of the grid.
+    class Neighbourhood {
+    public:
+                    Neighbourhood(const Grid2D* grid, uint32_t x, uint32_t y) : grid_(grid), x_(x), y_(y) { }
+        // Returns the neighbour at the specified offset, where each offset is in the range -1 to 1.
+        const T&    operator()(int dx, int dy) const { return grid_->data_[grid_->index(x_ + dx, y_ + dy)]; }
+        const T&    centre() const { return grid_->data_[grid_->index(x_, y_)]; }   // Returns the centre tile.
+        T           max() const // Returns the highest value in the neighbourhood, including the centre tile.
+        {
+            T highest = centre();
+            for (int dy = -1; dy <= 1; dy++)
+                for (int dx = -1; dx <= 1; dx++)
+                    if (highest < (*this)(dx, dy)) highest = (*this)(dx, dy);
+            return highest;
+        }
+        T           min() const // Returns the lowest value in the neighbourhood, including the centre tile.
+        {
+            T lowest = centre();
+            for (int dy = -1; dy <= 1; dy++)
+                for (int dx = -1; dx <= 1; dx++)
+                    if ((*this)(dx, dy) < lowest) lowest = (*this)(dx, dy);
+            return lowest;
+        }
+
+    private:
+        const Grid2D*   grid_;  // The grid being viewed.
+        uint32_t        x_, y_; // The coordinates of the centre tile.
+    };
+
+                Grid2D() : height_(0), tiles_x_(0), width_(0) { }
+                Grid2D(Vector2u size, const T &value = T()) : Grid2D() { resize(size, value); }   // Creates a new grid, filled with the specified value.
+    T&          operator()(uint32_t x, uint32_t y) { return data_[index(x, y)]; }   // Unchecked access to a tile.
+    const T&    operator()(uint32_t x, uint32_t y) const { return data_[index(x, y)]; }
+    T&          at(Vector2u pos) { return data_[checked_index(pos)]; }  // Bounds-checked access to a tile.
+    const T&    at(Vector2u pos) const { return data_[checked_index(pos)]; }
+    bool        contains(int x, int y) const    // Checks if the specified coordinates are within the grid.
+    { return x >= 0 && y >= 0 && static_cast<uint32_t>(x) < width_ && static_cast<uint32_t>(y) < height_; }
+    T*          data() { return data_.data(); } // Direct access to the underlying storage. Note that TILED grids are padded to whole tiles.
+    const T*    data() const { return data_.data(); }
+    void        fill(const T &value) { std::fill(data_.begin(), data_.end(), value); }  // Sets every tile in the grid to the specified value.
+    // Calls fn(x, y) for each in-bounds neighbour of the specified tile.
+    template<typename Fn> void  for_each_neighbour(Vector2u pos, GridNeighbours neighbours, Fn fn) const
+    {
+        for (int dy = -1; dy <= 1; dy++)
+        {
+            for (int dx = -1; dx <= 1; dx++)
+            {
+                if ((!dx && !dy) || (neighbours == GridNeighbours::ORTHOGONAL && dx && dy)) continue;
+                const int nx = static_cast<int>(pos.x) + dx, ny = static_cast<int>(pos.y) + dy;
+                if (contains(nx, ny)) fn(static_cast<uint32_t>(nx), static_cast<uint32_t>(ny));
+            }
+        }
+    }
+    uint32_t    height() const { return height_; }  // The height of the grid.
+    // Returns the storage index for the specified coordinates, without bounds checks.
+    uint32_t    index(uint32_t x, uint32_t y) const
+    {
+        if constexpr (L == GridLayout::ROW_MAJOR) return (y * width_) + x;
+        else return ((((y >> TILE_SHIFT) * tiles_x_) + (x >> TILE_SHIFT)) << (TILE_SHIFT * 2)) + morton(x & TILE_MASK, y & TILE_MASK);
+    }
+    Neighbourhood   neighbourhood(uint32_t x, uint32_t y) const { return Neighbourhood(this, x, y); }   // Unchecked 3x3 view around a non-edge tile.
+    void        resize(Vector2u size, const T &value = T())  // Resizes the grid, discarding its contents and filling it with the specified value.
+    {
+        width_ = size.x;
+        height_ = size.y;
+        if constexpr (L == GridLayout::ROW_MAJOR) data_.assign(width_ * height_, value);
+        else
+        {
+            tiles_x_ = (width_ + TILE_MASK) >> TILE_SHIFT;
+            data_.assign(tiles_x_ * ((height_ + TILE_MASK) >> TILE_SHIFT) * TILE_AREA, value);
+        }
+    }
+    Row<T, Grid2D*> row(uint32_t y) { return Row<T, Grid2D*>(this, y); }    // Returns a range over a single row, for range-based for loops.
+    Row<const T, const Grid2D*> row(uint32_t y) const { return Row<const T, const Grid2D*>(this, y); }
+    // Returns a raw pointer to the start of a row. Only available with the ROW_MAJOR layout, where rows are contiguous.
+    T*          row_data(uint32_t y) { static_assert(L == GridLayout::ROW_MAJOR, "row_data() requires ROW_MAJOR layout"); return data_.data() + (y * width_); }
+    const T*    row_data(uint32_t y) const
+    { static_assert(L == GridLayout::ROW_MAJOR, "row_data() requires ROW_MAJOR layout"); return data_.data() + (y * width_); }
+    Vector2u    size() const { return { width_, height_ }; }    // The width and height of the grid.
+    size_t      storage_size() const { return data_.size(); }   // The number of elements in the underlying storage, including any padding.
+    uint32_t    width() const { return width_; }    // The width of the grid.
+
+private:
+    // Returns the storage index for the specified coordinates, throwing an exception if they're out of bounds.
+    uint32_t    checked_index(Vector2u pos) const
+    {
+        if (pos.x >= width_ || pos.y >= height_) throw GuruMeditation("Grid2D given invalid coords", pos.x, pos.y);
+        return index(pos.x, pos.y);
+    }
+    // Interleaves the bits of two 3-bit coordinates into a 6-bit Morton index.
+    static uint32_t morton(uint32_t x, uint32_t y)
+    {
+        auto spread = [](uint32_t v) { v = (v | (v << 2)) & 0x33; return (v | (v << 1)) & 0x55; };
+        return spread(x) | (spread(y) << 1);
+    }
+
+    std::vector<T>  data_;      // The grid's contents.
+    uint32_t        height_;    // The height of the grid.
+    uint32_t        tiles_x_;   // The number of tiles across the width of the grid (TILED layout only).
+    uint32_t        width_;     // The width of the grid.
+};
+
+}   // namespace gorp
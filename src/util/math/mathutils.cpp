@@ -18,5 +18,17 @@ uint32_t array_index(Vector2u position, Vector2u array_size)
     return (position.y * array_size.x) + position.x;
 }
 
+// Hashes a block of memory with 64-bit FNV-1a.
+uint64_t fnv1a(const void* data, size_t size, uint64_t hash)
+{
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= FNV1A_PRIME;
+    }
+    return hash;
+}
+
 }   // namespace mathutils
 }   // namespace gorp
@@ -11,7 +11,14 @@
 namespace gorp {
 namespace mathutils {
 
+constexpr uint64_t  FNV1A_OFFSET_BASIS =  14695981039346656037ULL;  // The initial value for a 64-bit FNV-1a hash.
+constexpr uint64_t  FNV1A_PRIME =         1099511628211ULL;         // The 64-bit FNV-1a prime multiplier.
+
 uint32_t    array_index(Vector2u position, Vector2u array_size);  // Takes X,Y coordinates, and returns a flat array index for the coordinates.
+uint64_t    fnv1a(const void* data, size_t size, uint64_t hash = FNV1A_OFFSET_BASIS);   // Hashes a block of memory with 64-bit FNV-1a.
+
+// Hashes a single value of a basic data type (integer, float, etc.) with 64-bit FNV-1a, chaining from a previous hash.
+template<typename T> uint64_t   fnv1a_value(T value, uint64_t hash = FNV1A_OFFSET_BASIS) { return fnv1a(&value, sizeof(T), hash); }
 
 }   // namespace mathutils
 }   // namespace gorp
@@ -0,0 +1,116 @@
+// util/math/poisson-disc.cpp -- Bridson's Poisson-disc sampling over tile maps, for scattering points with a guaranteed minimum spacing.
+
+// SPDX-FileType: SOURCE
+// SPDX-FileCopyrightText: Copyright 2025 Raine Simmons <gc@gravecat.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <algorithm>
+#include <cmath>
+
+#include "util/math/grid2d.hpp"
+#include "util/math/poisson-disc.hpp"
+#include "util/math/rng.hpp"
+
+namespace gorp {
+namespace poissondisc {
+
+// Scatters points within the tiles from min to max (exclusive), each at least radius tiles from every other point and from every obstacle.
+std::vector<Vector2u> sample(Vector2u min, Vector2u max, float radius, RNG &rng, const std::vector<Vector2u> &seeds,
+    const std::function<bool(uint32_t, uint32_t)> &accept, const std::vector<Vector2u> &obstacles, uint32_t attempts)
+{
+    std::vector<Vector2u> result;
+    if (max.x <= min.x || max.y <= min.y || radius <= 0.0f) return result;
+
+    // Points are kept relative to min, at tile centres, so that every point maps cleanly back onto a tile. The background grid's cells are small enough
+    // that each can hold at most one point, so only the 5x5 block of cells around a candidate ever needs checking.
+    struct Point { float x, y; };
+    const float width = max.x - min.x, height = max.y - min.y;
+    const float cell_size = radius / std::sqrt(2.0f);
+    const float radius_squared = radius * radius;
+    Grid2D<int32_t> grid(Vector2u(static_cast<uint32_t>(std::ceil(width / cell_size)), static_cast<uint32_t>(std::ceil(height / cell_size))), -1);
+    std::vector<Point> points;  // Every point placed, plus the obstacles inside the sampled area, which sampling grows out from.
+    std::vector<uint32_t> active;   // Indexes of points (obstacles included) that may still have room around them.
+
+    // Obstacles are kept out of the grid, as any number of them can be close together, and those just outside the sampled area still count. Instead
+    // they're bucketed into cells one radius wide, covering the sampled area plus a border of one radius, so only the 3x3 block of cells around a
+    // candidate ever needs checking. Anything beyond the border is too far away to matter.
+    const int obstacle_cols = static_cast<int>(std::ceil(width / radius)) + 2, obstacle_rows = static_cast<int>(std::ceil(height / radius)) + 2;
+    std::vector<std::vector<Point>> obstacle_cells(obstacle_cols * obstacle_rows);
+
+    auto too_close = [&](const Point &p)
+    {
+        const int cx = static_cast<int>(p.x / cell_size), cy = static_cast<int>(p.y / cell_size);
+        for (int y = cy - 2; y <= cy + 2; y++)
+        {
+            for (int x = cx - 2; x <= cx + 2; x++)
+            {
+                if (!grid.contains(x, y)) continue;
+                const int32_t other = grid(x, y);
+                if (other < 0) continue;
+                const float dx = points[other].x - p.x, dy = points[other].y - p.y;
+                if ((dx * dx) + (dy * dy) < radius_squared) return true;
+            }
+        }
+        const int ox = static_cast<int>((p.x + radius) / radius), oy = static_cast<int>((p.y + radius) / radius);
+        for (int y = std::max(oy - 1, 0); y <= std::min(oy + 1, obstacle_rows - 1); y++)
+        {
+            for (int x = std::max(ox - 1, 0); x <= std::min(ox + 1, obstacle_cols - 1); x++)
+            {
+                for (const Point &obstacle : obstacle_cells[(y * obstacle_cols) + x])
+                {
+                    const float dx = obstacle.x - p.x, dy = obstacle.y - p.y;
+                    if ((dx * dx) + (dy * dy) < radius_squared) return true;
+                }
+            }
+        }
+        return false;
+    };
+    // Candidates are snapped to the centre of their tile before anything else, so the spacing is checked between the tiles actually returned.
+    auto try_point = [&](const Point &candidate)
+    {
+        if (candidate.x < 0.0f || candidate.y < 0.0f || candidate.x >= width || candidate.y >= height) return false;
+        const Point p = { std::floor(candidate.x) + 0.5f, std::floor(candidate.y) + 0.5f };
+        if (too_close(p) || !accept(min.x + static_cast<uint32_t>(p.x), min.y + static_cast<uint32_t>(p.y))) return false;
+        grid(static_cast<uint32_t>(p.x / cell_size), static_cast<uint32_t>(p.y / cell_size)) = points.size();
+        active.push_back(points.size());
+        points.push_back(p);
+        result.push_back({min.x + static_cast<uint32_t>(p.x), min.y + static_cast<uint32_t>(p.y)});
+        return true;
+    };
+
+    for (auto obstacle : obstacles)
+    {
+        const Point p = { static_cast<float>(obstacle.x) - min.x + 0.5f, static_cast<float>(obstacle.y) - min.y + 0.5f };
+        if (p.x < -radius || p.y < -radius || p.x >= width + radius || p.y >= height + radius) continue;
+        obstacle_cells[(static_cast<int>((p.y + radius) / radius) * obstacle_cols) + static_cast<int>((p.x + radius) / radius)].push_back(p);
+        if (p.x < 0.0f || p.y < 0.0f || p.x >= width || p.y >= height) continue;
+        active.push_back(points.size());
+        points.push_back(p);
+    }
+    for (auto seed : seeds)
+        try_point({ static_cast<float>(seed.x) - min.x + 0.5f, static_cast<float>(seed.y) - min.y + 0.5f });
+
+    // Bridson's algorithm: pick a random active point, and try candidates in the annulus between radius and twice the radius around it. If none fit,
+    // the point is surrounded, and is retired.
+    while (active.size())
+    {
+        const size_t active_index = rng.get<size_t>(0, active.size() - 1);
+        const Point centre = points[active[active_index]];
+        bool placed = false;
+        for (uint32_t i = 0; i < attempts && !placed; i++)
+        {
+            const float angle = rng.get(0.0f, static_cast<float>(M_PI * 2.0));
+            const float distance = radius * std::sqrt(rng.get(1.0f, 4.0f));  // Uniform over the annulus' area.
+            placed = try_point({ centre.x + (std::cos(angle) * distance), centre.y + (std::sin(angle) * distance) });
+        }
+        if (!placed)
+        {
+            active[active_index] = active.back();
+            active.pop_back();
+        }
+    }
+    return result;
+}
+
+}   // namespace poissondisc
+}   // namespace gorp
@@ -0,0 +1,30 @@
+// util/math/poisson-disc.hpp -- Bridson's Poisson-disc sampling over tile maps, for scattering points with a guaranteed minimum spacing.
+
+// SPDX-FileType: SOURCE
+// SPDX-FileCopyrightText: Copyright 2025 Raine Simmons <gc@gravecat.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <functional>
+
+#include "core/global.hpp"
+
+namespace gorp {
+
+class RNG;  // defined in util/math/rng.hpp
+
+namespace poissondisc {
+
+constexpr uint32_t  ATTEMPTS_DEFAULT =  30; // The number of candidates tried around each active point before it's retired, as suggested by Bridson.
+
+// Scatters points within the tiles from min to max (exclusive), each at least radius tiles from every other point and from every obstacle, keeping only
+// points where accept(x, y) is true. Sampling grows outwards from the obstacles and from whichever seed points are accepted, so seeds should lie inside
+// the area of interest.
+// A background grid makes each distance check constant-time, so the whole thing runs in time linear in the number of points placed (plus the number of
+// obstacles, as long as they're not all crowded together). Returns the tile coordinates of every point placed, not including obstacles.
+std::vector<Vector2u>   sample(Vector2u min, Vector2u max, float radius, RNG &rng, const std::vector<Vector2u> &seeds,
+    const std::function<bool(uint32_t, uint32_t)> &accept, const std::vector<Vector2u> &obstacles = {}, uint32_t attempts = ATTEMPTS_DEFAULT);
+
+}   // namespace poissondisc
+}   // namespace gorp
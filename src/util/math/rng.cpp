@@ -0,0 +1,47 @@
+// util/math/rng.cpp -- A small, fast, splittable PRNG (xoshiro256**), for reproducible generation that doesn't depend on call order or threads.
+// Each subsystem should take its own named stream with split(), rather than sharing one engine, so that generating one thing never changes another.
+
+// SPDX-FileType: SOURCE
+// SPDX-FileCopyrightText: Copyright 2025 Raine Simmons <gc@gravecat.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "util/math/mathutils.hpp"
+#include "util/math/rng.hpp"
+
+namespace gorp {
+
+// Creates a new stream from a 64-bit seed.
+RNG::RNG(uint64_t seed) : seed_(seed)
+{
+    uint64_t splitmix_state = seed;
+    for (int i = 0; i < 4; i++)
+        state_[i] = splitmix64(splitmix_state);
+}
+
+// The seed this stream was created from.
+uint64_t RNG::seed() const { return seed_; }
+
+// Derives a new, independent stream from this stream's seed and a name.
+RNG RNG::split(const std::string &name) const
+{
+    uint64_t hash = mathutils::fnv1a(name.data(), name.size(), mathutils::fnv1a_value(seed_));
+    return RNG(splitmix64(hash));
+}
+
+// As above, but derives a numbered stream.
+RNG RNG::split(uint64_t index) const
+{
+    uint64_t hash = mathutils::fnv1a_value(index, mathutils::fnv1a_value(seed_ ^ 0x9E3779B97F4A7C15ULL));
+    return RNG(splitmix64(hash));
+}
+
+// The SplitMix64 generator, used to expand a seed into the full xoshiro state.
+uint64_t RNG::splitmix64(uint64_t &state)
+{
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+}   // namespace gorp
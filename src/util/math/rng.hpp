@@ -0,0 +1,69 @@
+// util/math/rng.hpp -- A small, fast, splittable PRNG (xoshiro256**), for reproducible generation that doesn't depend on call order or threads.
+// Each subsystem should take its own named stream with split(), rather than sharing one engine, so that generating one thing never changes another.
+
+// SPDX-FileType: SOURCE
+// SPDX-FileCopyrightText: Copyright 2025 Raine Simmons <gc@gravecat.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <type_traits>
+
+#include "core/global.hpp"
+
+namespace gorp {
+
+class RNG {
+public:
+    using result_type = uint64_t;   // Allows RNG to be used with the standard library, e.g. std::shuffle.
+
+    explicit    RNG(uint64_t seed);     // Creates a new stream from a 64-bit seed.
+    static constexpr result_type min() { return 0; }            // The lowest possible output of next().
+    static constexpr result_type max() { return UINT64_MAX; }   // The highest possible output of next().
+    result_type operator()() { return next(); }                 // Returns the next raw 64-bit value.
+    // Returns a uniformly-distributed number between min and max (inclusive for integers, exclusive of max for floating-point types).
+    template<typename T> T  get(T min, T max)
+    {
+        static_assert(std::is_arithmetic<T>::value, "RNG::get() requires an arithmetic type");
+        if (max < min) throw GuruMeditation("RNG::get() given invalid range");
+        if constexpr (std::is_floating_point<T>::value) return min + static_cast<T>(get_double() * (static_cast<double>(max) - min));
+        else
+        {
+            // Rejection sampling, to avoid modulo bias.
+            const uint64_t range = static_cast<uint64_t>(max) - static_cast<uint64_t>(min);
+            if (range == UINT64_MAX) return static_cast<T>(next());
+            const uint64_t buckets = range + 1, limit = UINT64_MAX - (UINT64_MAX % buckets);
+            uint64_t value;
+            do { value = next(); } while (value >= limit);
+            return static_cast<T>(static_cast<uint64_t>(min) + (value % buckets));
+        }
+    }
+    bool        get_bool(float probability = 0.5f) { return get_double() < probability; }   // Returns true with the specified probability.
+    double      get_double() { return (next() >> 11) * 0x1.0p-53; }    // Returns a uniformly-distributed double in the range [0, 1).
+    uint64_t    next()  // Returns the next raw 64-bit value from the stream.
+    {
+        const uint64_t result = rotl(state_[1] * 5, 7) * 9;
+        const uint64_t t = state_[1] << 17;
+        state_[2] ^= state_[0];
+        state_[3] ^= state_[1];
+        state_[1] ^= state_[2];
+        state_[0] ^= state_[3];
+        state_[2] ^= t;
+        state_[3] = rotl(state_[3], 45);
+        return result;
+    }
+    uint64_t    seed() const;   // The seed this stream was created from.
+    // Derives a new, independent stream from this stream's seed and a name (e.g. "namegen"). The result depends only on the seed and the name, not on
+    // how many numbers have already been drawn, so subsystems can't disturb each other's output.
+    RNG         split(const std::string &name) const;
+    RNG         split(uint64_t index) const;    // As above, but derives a numbered stream (e.g. per chunk or per tile), for handing work out to threads.
+
+private:
+    static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); } // Rotates bits left.
+    static uint64_t splitmix64(uint64_t &state);    // The SplitMix64 generator, used to expand a seed into the full xoshiro state.
+
+    uint64_t    seed_;      // The seed this stream was created from.
+    uint64_t    state_[4];  // The xoshiro256** state.
+};
+
+}   // namespace gorp
@@ -0,0 +1,85 @@
+// util/math/stencil.hpp -- 3x3 neighbourhood kernels (max, min, blur, or custom) over row-major 2D maps, reading one buffer and writing another.
+
+// SPDX-FileType: SOURCE
+// SPDX-FileCopyrightText: Copyright 2025 Raine Simmons <gc@gravecat.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include "core/global.hpp"
+
+namespace gorp {
+namespace stencil {
+
+// How tiles on the outer edge of the map are handled, where the 3x3 neighbourhood would fall outside the map.
+enum class Border : uint8_t {
+    COPY,   // Edge tiles are copied unchanged from the source. A map less than 3 tiles wide or high has no interior, so it's copied through whole.
+    CLAMP   // The kernel is applied to edge tiles too, with out-of-bounds neighbours clamped to the nearest edge tile.
+};
+
+// Applies a 3x3 kernel to every tile of a row-major map, reading from src and writing to dst, which must not overlap. Because the source is never written
+// to, results do not depend on scan order. The kernel is called as kernel(nw, n, ne, w, c, e, sw, s, se) and returns the new value for the centre tile.
+// The interior is processed separately from the edges, with unchecked pointer access, so a branch-free kernel can be auto-vectorized by the compiler.
+template<typename T, typename Kernel> void apply(const T* src, T* dst, Vector2u size, Kernel kernel, Border border = Border::COPY)
+{
+    const uint32_t width = size.x, height = size.y;
+    if (!width || !height) return;
+
+    // The interior, which never needs bounds checks.
+    for (uint32_t y = 1; y + 1 < height; y++)
+    {
+        const T* above = src + ((y - 1) * width);
+        const T* mid = src + (y * width);
+        const T* below = src + ((y + 1) * width);
+        T* out = dst + (y * width);
+        for (uint32_t x = 1; x + 1 < width; x++)
+            out[x] = kernel(above[x - 1], above[x], above[x + 1], mid[x - 1], mid[x], mid[x + 1], below[x - 1], below[x], below[x + 1]);
+    }
+
+    // The edges, with clamped coordinates.
+    auto edge_tile = [&](uint32_t x, uint32_t y)
+    {
+        const uint32_t xl = x ? x - 1 : 0, xr = x + 1 < width ? x + 1 : x, yu = y ? y - 1 : 0, yd = y + 1 < height ? y + 1 : y;
+        const T* above = src + (yu * width);
+        const T* mid = src + (y * width);
+        const T* below = src + (yd * width);
+        if (border == Border::COPY) dst[(y * width) + x] = mid[x];
+        else dst[(y * width) + x] = kernel(above[xl], above[x], above[xr], mid[xl], mid[x], mid[xr], below[xl], below[x], below[xr]);
+    };
+    for (uint32_t x = 0; x < width; x++)
+    {
+        edge_tile(x, 0);
+        if (height > 1) edge_tile(x, height - 1);
+    }
+    for (uint32_t y = 1; y + 1 < height; y++)
+    {
+        edge_tile(0, y);
+        if (width > 1) edge_tile(width - 1, y);
+    }
+}
+
+// Box blur: each tile becomes the mean of its 3x3 neighbourhood.
+template<typename T> void blur(const T* src, T* dst, Vector2u size, Border border = Border::CLAMP)
+{
+    apply(src, dst, size, [](T nw, T n, T ne, T w, T c, T e, T sw, T s, T se) { return static_cast<T>((nw + n + ne + w + c + e + sw + s + se) / 9); },
+        border);
+}
+
+// Each tile becomes the highest value in its 3x3 neighbourhood (greyscale dilation).
+template<typename T> void max(const T* src, T* dst, Vector2u size, Border border = Border::CLAMP)
+{
+    auto max2 = [](T a, T b) { return a < b ? b : a; };
+    apply(src, dst, size, [max2](T nw, T n, T ne, T w, T c, T e, T sw, T s, T se)
+        { return max2(max2(max2(nw, n), max2(ne, w)), max2(max2(max2(c, e), max2(sw, s)), se)); }, border);
+}
+
+// Each tile becomes the lowest value in its 3x3 neighbourhood (greyscale erosion).
+template<typename T> void min(const T* src, T* dst, Vector2u size, Border border = Border::CLAMP)
+{
+    auto min2 = [](T a, T b) { return b < a ? b : a; };
+    apply(src, dst, size, [min2](T nw, T n, T ne, T w, T c, T e, T sw, T s, T se)
+        { return min2(min2(min2(nw, n), min2(ne, w)), min2(min2(min2(c, e), min2(sw, s)), se)); }, border);
+}
+
+}   // namespace stencil
+}   // namespace gorp
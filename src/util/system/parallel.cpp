@@ -0,0 +1,132 @@
+// util/system/parallel.cpp -- Simple helpers for splitting independent work across threads.
+
+// SPDX-FileType: SOURCE
+// SPDX-FileCopyrightText: Copyright 2025 Raine Simmons <gc@gravecat.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <list>
+#include <mutex>
+#include <thread>
+
+#include "util/system/parallel.hpp"
+
+namespace gorp {
+namespace parallel {
+
+// A single for_each() call, shared between the calling thread and any pool threads helping with it.
+struct Job
+{
+    unsigned int        active = 0;     // The number of pool threads currently working on this job. Guarded by the pool mutex.
+    uint32_t            count;          // The number of calls to make.
+    std::mutex          exception_mutex;    // Guards first_exception.
+    std::exception_ptr  first_exception;    // The first exception thrown by any call, to be rethrown by for_each().
+    const std::function<void(uint32_t)> &fn;    // The function to call.
+    std::atomic<uint32_t>   next_index; // The next index to hand out.
+
+    Job(uint32_t job_count, const std::function<void(uint32_t)> &job_fn) : count(job_count), fn(job_fn), next_index(0) { }
+    bool    exhausted() const { return next_index >= count; }   // Checks if every index has been handed out.
+
+    // Makes calls until every index has been handed out.
+    void    run()
+    {
+        uint32_t i;
+        while ((i = next_index.fetch_add(1)) < count)
+        {
+            try { fn(i); }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(exception_mutex);
+                if (!first_exception) first_exception = std::current_exception();
+                next_index = count; // Stop handing out any more work.
+            }
+        }
+    }
+};
+
+// The worker threads, started on the first call to for_each() and kept for the life of the program, so that each call doesn't pay for creating and
+// joining threads. Several threads can call for_each() at once (the world streams in islands on more than one thread), so the pool works through a list
+// of jobs, and the caller always works on its own job too, so it finishes even if every pool thread is busy elsewhere.
+class Pool {
+public:
+    // Starts the worker threads.
+    Pool(unsigned int threads)
+    {
+        for (unsigned int t = 0; t < threads; t++)
+            std::thread(&Pool::worker, this).detach();
+    }
+
+    // Runs a job on the calling thread and the pool, returning once every call has finished.
+    void run(Job &job)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            jobs_.push_back(&job);
+        }
+        work_cv_.notify_all();
+        job.run();
+
+        // Once the job is off the list, no more pool threads can pick it up, so it just has to wait for those already on it.
+        std::unique_lock<std::mutex> lock(mutex_);
+        jobs_.remove(&job);
+        done_cv_.wait(lock, [&job] { return !job.active; });
+    }
+
+private:
+    // The worker thread loop, helping with whichever job is at the front of the list.
+    void worker()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true)
+        {
+            work_cv_.wait(lock, [this] { return jobs_.size(); });
+            Job* job = jobs_.front();
+            if (job->exhausted())
+            {
+                jobs_.pop_front();
+                continue;
+            }
+            job->active++;
+            lock.unlock();
+            job->run();
+            lock.lock();
+            job->active--;
+            jobs_.remove(job);
+            done_cv_.notify_all();
+        }
+    }
+
+    std::condition_variable done_cv_;   // Signalled when a pool thread finishes with a job.
+    std::list<Job*>         jobs_;      // Jobs that may still have indices to hand out.
+    std::mutex              mutex_;     // Guards jobs_, and each job's active count.
+    std::condition_variable work_cv_;   // Signalled when a new job is added.
+};
+
+// Calls fn(i) for every i from 0 to count - 1, spread across worker threads, and returns once all calls have finished.
+void for_each(uint32_t count, const std::function<void(uint32_t)> &fn)
+{
+    if (count < 2 || thread_count() < 2)
+    {
+        for (uint32_t i = 0; i < count; i++)
+            fn(i);
+        return;
+    }
+
+    // The pool is never destroyed, as its threads may still be waiting for work when the program exits, and joining them then would serve no purpose.
+    static Pool* pool = new Pool(thread_count() - 1);
+    Job job(count, fn);
+    pool->run(job);
+    if (job.first_exception) std::rethrow_exception(job.first_exception);
+}
+
+// The number of worker threads for_each() will use at most.
+unsigned int thread_count()
+{
+    const unsigned int hardware_threads = std::thread::hardware_concurrency();
+    return hardware_threads ? hardware_threads : 1;
+}
+
+}   // namespace parallel
+}   // namespace gorp
@@ -0,0 +1,23 @@
+// util/system/parallel.hpp -- Simple helpers for splitting independent work across threads.
+
+// SPDX-FileType: SOURCE
+// SPDX-FileCopyrightText: Copyright 2025 Raine Simmons <gc@gravecat.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <functional>
+
+#include "core/global.hpp"
+
+namespace gorp {
+namespace parallel {
+
+// Calls fn(i) for every i from 0 to count - 1, spread across worker threads, and returns once all calls have finished. The calls may run in any order,
+// so each one must only touch data that no other call touches. If any call throws, the first exception is rethrown here once the workers have stopped.
+// The worker threads are kept in a pool between calls, and any thread can call this, including from inside another call.
+void            for_each(uint32_t count, const std::function<void(uint32_t)> &fn);
+unsigned int    thread_count(); // The number of worker threads for_each() will use at most.
+
+}   // namespace parallel
+}   // namespace gorp
@@ -10,22 +10,26 @@
 
 namespace gorp {
 
+class DataPack;     // defined in util/file/datapack.hpp
+class RNG;          // defined in util/math/rng.hpp
+
+// All randomness comes from the RNG stream passed in, so the same stream always produces the same names, and several threads can share one ProcNameGen.
 class ProcNameGen {
 public:
-    void        load_namelists();   // Loads the namelists from the data files.
-    std::string npc_name(Gender gender, bool with_surname = true);  // Generates a random NPC name, using a combination of the other systems.
+    void        load_namelists(const DataPack &data);   // Loads the namelists from the compiled data pack.
+    std::string npc_name(RNG &rng, Gender gender, bool with_surname = true);    // Generates a random NPC name, using a combination of the other systems.
 
 private:
-    std::string consonant();    // Picks a consonant from the table, for forming atoms.
-    std::string name_f();       // Returns a random feminine name.
-    std::string name_m();       // Returns a random masculine name.
-    std::string namegen_v1();   // Generates a random name (v1 code, Elite-style).
+    std::string consonant(RNG &rng);    // Picks a consonant from the table, for forming atoms.
+    std::string name_f(RNG &rng);       // Returns a random feminine name.
+    std::string name_m(RNG &rng);       // Returns a random masculine name.
+    std::string namegen_v1(RNG &rng);   // Generates a random name (v1 code, Elite-style).
     std::string namegen_v3();
-    std::string namegen_v4(const std::string& pattern, unsigned int max_len = 8, unsigned int min_len = 2); // Generates a name with the v4 generator.
-    std::string pv3_t();        // Ends of words.
-    std::string random_word(bool cap = false);  // Generates a random word.
-    std::string surname();      // Generates a random surname.
-    std::string vowel();        // Picks a vowel from the table, for forming atoms.
+    std::string namegen_v4(RNG &rng, const std::string& pattern, unsigned int max_len = 8, unsigned int min_len = 2); // Generates a name with the v4 generator.
+    std::string pv3_t(RNG &rng);        // Ends of words.
+    std::string random_word(RNG &rng, bool cap = false);  // Generates a random word.
+    std::string surname(RNG &rng);      // Generates a random surname.
+    std::string vowel(RNG &rng);        // Picks a vowel from the table, for forming atoms.
 
     std::string                 consonant_block;    // The consonant letter block, for v1 naming.
     std::vector<std::string>    names_f;            // Hard-coded names list of feminine first-names.
@@ -179,6 +179,23 @@ std::string replace_keep_capitalization(const std::string &input, const std::str
     return result;
 }
 
+// Splits text into lines, the same way fileutils::file_to_vec() reads a file.
+std::vector<std::string> split_lines(std::string_view str)
+{
+    std::vector<std::string> lines;
+    size_t start = 0;
+    while (start < str.size())
+    {
+        size_t end = str.find('\n', start);
+        if (end == std::string_view::npos) end = str.size();
+        std::string_view line = str.substr(start, end - start);
+        if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+        lines.emplace_back(line);
+        start = end + 1;
+    }
+    return lines;
+}
+
 // Converts a string to lower-case.
 std::string str_tolower(std::string str)
 {
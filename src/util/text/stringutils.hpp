@@ -6,6 +6,8 @@
 
 #pragma once
 
+#include <string_view>
+
 #include "core/global.hpp"
 
 namespace gorp {
@@ -18,6 +20,7 @@ std::string     itoh(uint32_t num, uint8_t min_len);    // Converts an integer i
 std::string     join_words(std::vector<std::string> vec, const std::string &spacer = " ");  // Takes a vector of strings and squashes them into one string.
                 // Replaces input with output, maintaining the capitalization of input (e.g. input="Meow" output="cat" result="Cat")
 std::string     replace_keep_capitalization(const std::string &input, const std::string &output);
+std::vector<std::string>    split_lines(std::string_view str);  // Splits text into lines, the same way fileutils::file_to_vec() reads a file.
 std::string     str_tolower(std::string str);   // Converts a string to lower-case.
 std::string     str_toupper(std::string str);   // Converts a string to upper-case.
 std::vector<std::string>    string_explode(std::string str, const std::string &separator);  // String split/explode function.
@@ -0,0 +1,59 @@
+// world/chunk-delta.cpp -- A sparse record of the changes made to a chunk since it was generated, which is all a save has to keep of it.
+
+// SPDX-FileType: SOURCE
+// SPDX-FileCopyrightText: Copyright 2025 Raine Simmons <gc@gravecat.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "util/file/filereader.hpp"
+#include "util/file/filewriter.hpp"
+#include "world/chunk-delta.hpp"
+#include "world/island-data.hpp"
+
+namespace gorp {
+
+// A delta is a varint count of changed tiles, then for each tile in index order, a varint gap from the previous tile's index (or from zero, for the
+// first), and the tile's packed terrain byte. Changes tend to cluster, so most tiles cost two bytes.
+
+// Checks if nothing has changed.
+bool ChunkDelta::empty() const { return terrain_.empty(); }
+
+// Reads a delta written by save(), checking that every tile is within a chunk of the specified number of tiles, and every packed terrain byte is
+// valid. Throws on failure.
+void ChunkDelta::load(FileReader &file, uint32_t tile_count)
+{
+    terrain_.clear();
+    const uint64_t count = file.read_varint();
+    if (count > tile_count) throw std::runtime_error("Invalid chunk delta size!");
+    uint64_t index = 0;
+    for (uint64_t i = 0; i < count; i++)
+    {
+        const uint64_t gap = file.read_varint();
+        if (i && !gap) throw std::runtime_error("Invalid chunk delta order!");
+        index += gap;
+        if (index >= tile_count) throw std::runtime_error("Invalid chunk delta tile!");
+        const uint8_t terrain = file.read_data<uint8_t>();
+        if (!IslandData::valid_terrain(terrain)) throw std::runtime_error("Invalid chunk delta terrain!");
+        terrain_.emplace_hint(terrain_.end(), static_cast<uint32_t>(index), terrain);
+    }
+}
+
+// Writes the delta to a file.
+void ChunkDelta::save(FileWriter &file) const
+{
+    file.write_varint(terrain_.size());
+    uint32_t previous = 0;
+    for (const auto &[index, terrain] : terrain_)
+    {
+        file.write_varint(index - previous);
+        file.write_data<uint8_t>(terrain);
+        previous = index;
+    }
+}
+
+// Records a new packed terrain byte for a tile, by its index in the chunk.
+void ChunkDelta::set_terrain(uint32_t index, uint8_t terrain) { terrain_[index] = terrain; }
+
+// The changed packed terrain bytes, by tile index.
+const std::map<uint32_t, uint8_t>& ChunkDelta::terrain() const { return terrain_; }
+
+}   // namespace gorp
@@ -0,0 +1,36 @@
+// world/chunk-delta.hpp -- A sparse record of the changes made to a chunk since it was generated, which is all a save has to keep of it.
+
+// SPDX-FileType: SOURCE
+// SPDX-FileCopyrightText: Copyright 2025 Raine Simmons <gc@gravecat.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <map>
+
+#include "core/global.hpp"
+
+namespace gorp {
+
+class FileReader;   // defined in util/file/filereader.hpp
+class FileWriter;   // defined in util/file/filewriter.hpp
+
+// Chunks are fully determined by their seed and the generator's parameters, so rather than saving their tile data, a save only keeps the tiles that
+// have changed since generation. Whenever a chunk is loaded, it's regenerated (or loaded from the island cache) and its delta is replayed on top, so
+// save size and save time scale with what the player has changed, not with the size of the world. Changes never cross the coastline (see
+// World::set_terrain()), so everything derived from which tiles are land stays as it was generated.
+class ChunkDelta {
+public:
+    bool        empty() const;  // Checks if nothing has changed.
+    // Reads a delta written by save(), checking that every tile is within a chunk of the specified number of tiles, and every packed terrain byte is
+    // valid. Throws on failure.
+    void        load(FileReader &file, uint32_t tile_count);
+    void        save(FileWriter &file) const;   // Writes the delta to a file.
+    void        set_terrain(uint32_t index, uint8_t terrain);   // Records a new packed terrain byte for a tile, by its index in the chunk.
+    const std::map<uint32_t, uint8_t>&  terrain() const;    // The changed packed terrain bytes, by tile index.
+
+private:
+    std::map<uint32_t, uint8_t> terrain_;   // The changed packed terrain bytes, by tile index, kept sorted so the indices can be delta-coded on disk.
+};
+
+}   // namespace gorp
@@ -7,29 +7,104 @@
 #include "core/core.hpp"
 #include "core/game.hpp"
 #include "core/terminal/terminal.hpp"
+#include "util/file/binpath.hpp"
+#include "util/file/datapack.hpp"
+#include "util/file/fileutils.hpp"
+#include "util/file/yaml.hpp"
+#include "util/math/mathutils.hpp"
 #include "util/text/namegen.hpp"
 #include "util/text/stringutils.hpp"
 #include "world/codex.hpp"
 
 namespace gorp {
 
-// Loads the static data from the gorp.k10 datafile.
-Codex::Codex() : namegen_ptr_(std::make_unique<ProcNameGen>())
+// Starts loading the static data from the gorp.k10 datafile, on a background thread.
+Codex::Codex() : data_ptr_(nullptr), namegen_ptr_(std::make_unique<ProcNameGen>())
 {
+    // The Codex is created before the terminal window, so the data pack can be checked (or rebuilt) while the window and its textures are being set up.
     core().log("Loading static data into the codex...");
-    namegen_ptr_->load_namelists();
+    data_ready_ = std::async(std::launch::async, &Codex::load_pack, this).share();
 }
 
 // Destructor, explicitly frees memory used.
-Codex::~Codex() { namegen_ptr_.reset(nullptr); }
+Codex::~Codex()
+{
+    if (data_ready_.valid()) data_ready_.wait();    // Never tear anything down while the background thread might still be using it.
+    namegen_ptr_.reset(nullptr);
+    data_ptr_.reset(nullptr);
+}
+
+// Compiles the gamedata files into a new data pack.
+void Codex::compile_pack(uint64_t source_hash) const
+{
+    // Each text file becomes a list, keyed by its path without the extension. Each YAML file must be a map, and each of its keys becomes a list (for
+    // sequences) or a string (for anything else), keyed by the file's path without the extension, followed by the YAML key.
+    DataPackBuilder builder;
+    for (const std::string source : PACK_SOURCES)
+    {
+        const size_t extension = source.find_last_of('.');
+        const std::string key = source.substr(0, extension);
+        if (source.substr(extension) == ".txt") builder.add_list(key, stringutils::split_lines(core().read_datafile(source)));
+        else
+        {
+            YAML yaml;
+            yaml.load_string(core().read_datafile(source), source);
+            if (!yaml.is_map()) throw GuruMeditation(source + ": Invalid file format");
+            for (const auto &key_view : yaml.keys())
+            {
+                const std::string yaml_key(key_view);
+                if (yaml.get_child(yaml_key).is_seq()) builder.add_list(key + "/" + yaml_key, yaml.get_seq(yaml_key));
+                else builder.add_string(key + "/" + yaml_key, std::string(yaml.val(yaml_key)));
+            }
+        }
+    }
+    fileutils::make_dir(BinPath::game_path("userdata"));
+    builder.save(PACK_FILENAME, source_hash);
+}
+
+// Returns a reference to the compiled static data, waiting for it to finish loading if needed.
+const DataPack& Codex::data() const
+{
+    data_ready_.get();  // Rethrows anything thrown while loading.
+    if (!data_ptr_) throw std::runtime_error("Attempt to access null DataPack object!");
+    return *data_ptr_;
+}
+
+// Maps the data pack, compiling a new one first if it's missing or out of date.
+void Codex::load_pack()
+{
+    // The pack is only rebuilt when the gamedata files it was compiled from have changed, so on most runs, nothing is parsed at all.
+    const uint64_t hash = source_hash();
+    try { data_ptr_ = std::make_unique<DataPack>(PACK_FILENAME, hash); }
+    catch (const std::exception &e)
+    {
+        core().log(std::string(e.what()) + ", compiling a new data pack.");
+        compile_pack(hash);
+        data_ptr_ = std::make_unique<DataPack>(PACK_FILENAME, hash);
+    }
+}
 
-// Returns a reference to the procedural name generator object.
+// Returns a reference to the procedural name generator object, loading its namelists on first use.
 ProcNameGen& Codex::namegen() const
 {
     if (!namegen_ptr_) throw std::runtime_error("Attempt to access null ProcNameGen object!");
+    std::call_once(namegen_loaded_, [this] { namegen_ptr_->load_namelists(data()); });
     return *namegen_ptr_;
 }
 
+// Hashes the names and contents of every gamedata file that goes into the data pack.
+uint64_t Codex::source_hash() const
+{
+    uint64_t hash = mathutils::fnv1a_value<uint32_t>(DataPack::DATAPACK_VERSION);
+    for (const std::string source : PACK_SOURCES)
+    {
+        const std::string contents = core().read_datafile(source);
+        hash = mathutils::fnv1a(source.data(), source.size() + 1, hash);    // Including the null terminator keeps names and contents from running together.
+        hash = mathutils::fnv1a(contents.data(), contents.size(), hash);
+    }
+    return hash;
+}
+
 // Shortcut instead of using game()->codex()
 Codex& codex() { return game().codex(); }
 
@@ -6,21 +6,36 @@
 
 #pragma once
 
+#include <future>
 #include <map>
+#include <mutex>
 
 #include "core/global.hpp"
 
 namespace gorp {
 
+class DataPack;     // defined in util/file/datapack.hpp
 class ProcNameGen;  // defined in misc/namegen.hpp
 
 class Codex {
 public:
-                    Codex();    // Loads the static data from the gorp.k10 datafile.
+                    Codex();    // Starts loading the static data from the gorp.k10 datafile, on a background thread.
                     ~Codex();   // Destructor, explicitly frees memory used.
-    ProcNameGen&    namegen() const;    // Returns a reference to the procedural name generator object.
+    const DataPack& data() const;       // Returns a reference to the compiled static data, waiting for it to finish loading if needed.
+    ProcNameGen&    namegen() const;    // Returns a reference to the procedural name generator object, loading its namelists on first use.
 
 private:
+    static constexpr const char*    PACK_FILENAME = "userdata/gorp.k10";    // The compiled data pack, relative to the game's path.
+    static constexpr const char*    PACK_SOURCES[] = { "misc/title.yml", "namegen/namegen-strings.yml", "namegen/names-f.txt", "namegen/names-m.txt",
+        "namegen/surname-a.txt", "namegen/surname-b.txt" }; // The gamedata files compiled into the data pack.
+
+    void            compile_pack(uint64_t source_hash) const;   // Compiles the gamedata files into a new data pack.
+    void            load_pack();            // Maps the data pack, compiling a new one first if it's missing or out of date.
+    uint64_t        source_hash() const;    // Hashes the names and contents of every gamedata file that goes into the data pack.
+
+    std::unique_ptr<DataPack>       data_ptr_;          // Pointer to the memory-mapped data pack.
+    std::shared_future<void>        data_ready_;        // Becomes ready when the data pack has been loaded, or holds the exception if loading failed.
+    mutable std::once_flag          namegen_loaded_;    // Ensures the namelists are only loaded once, the first time they're needed.
     std::unique_ptr<ProcNameGen>    namegen_ptr_;       // Pointer to the procedural name-generator object.
 };
 
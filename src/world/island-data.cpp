@@ -0,0 +1,191 @@
+// world/island-data.cpp -- Compact, resident storage for generated islands: quantized heights, packed terrain classes and 16-bit region IDs.
+
+// SPDX-FileType: SOURCE
+// SPDX-FileCopyrightText: Copyright 2025 Raine Simmons <gc@gravecat.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <algorithm>
+#include <cmath>
+#include <utility>  // std::move
+
+#include "procgen/island.hpp"
+#include "world/chunk-delta.hpp"
+#include "world/island-data.hpp"
+#include "world/terrain-pyramid.hpp"
+
+namespace gorp {
+
+// Packs a generated island into compact form.
+IslandData::IslandData(const IslandProcGen &island) : points_of_interest_(island.points_of_interest()), region_count_(0), seed_(island.seed()),
+    size_(island.size())
+{
+    const float* height_map = island.height_map().data();
+    const int* sub_island_ids = island.sub_island_ids().data();
+    const float* distance_to_land = island.distance_to_land().data();
+    const float* distance_to_water = island.distance_to_water().data();
+    const uint8_t* rivers = island.river_map().data();
+    if (island.sub_island_coords().size() > REGION_MAX) throw GuruMeditation("Too many sub-islands to pack!", island.sub_island_coords().size());
+    region_count_ = island.sub_island_coords().size();
+
+    const uint32_t tiles = size_ * size_;
+    coast_distances_.resize(tiles);
+    heights_.resize(tiles);
+    regions_.resize(tiles);
+    terrain_.resize(tiles);
+    for (uint32_t i = 0; i < tiles; i++)
+    {
+        // The terrain class is determined from the unquantized height, so the thresholds are exact.
+        const float tile_height = height_map[i];
+        Terrain tile_terrain = Terrain::LAND;
+        if (tile_height <= IslandProcGen::HEIGHT_MAP_DEEP_WATER) tile_terrain = Terrain::DEEP_WATER;
+        else if (tile_height <= IslandProcGen::HEIGHT_MAP_WATER) tile_terrain = Terrain::WATER;
+        else if (tile_height <= IslandProcGen::HEIGHT_MAP_LOWLAND) tile_terrain = Terrain::LOWLAND;
+        else if (tile_height >= IslandProcGen::HEIGHT_MAP_MOUNTAIN_PEAK) tile_terrain = Terrain::PEAK;
+        else if (tile_height >= IslandProcGen::HEIGHT_MAP_MOUNTAIN) tile_terrain = Terrain::MOUNTAIN;
+        else if (tile_height >= IslandProcGen::HEIGHT_MAP_HIGHLAND) tile_terrain = Terrain::HIGHLAND;
+        heights_[i] = quantize_height(tile_height);
+        terrain_[i] = static_cast<uint8_t>(tile_terrain) | (rivers[i] ? TERRAIN_FLAG_RIVER : 0);
+
+        const int sub_island_id = sub_island_ids[i];
+        if (sub_island_id >= 0) regions_[i] = static_cast<uint16_t>(sub_island_id);
+        else if (sub_island_id == IslandProcGen::SUB_ISLAND_ID_TOO_SMALL) regions_[i] = REGION_TOO_SMALL;
+        else regions_[i] = REGION_WATER;
+
+        // Only one of the two distances is non-zero for any given tile, depending on which side of the coast it's on. An island with no land or no
+        // water has infinite distances, so they're clamped before rounding.
+        const float coast_distance = std::max(distance_to_land[i], distance_to_water[i]);
+        coast_distances_[i] = static_cast<uint8_t>(std::lround(std::min(coast_distance, static_cast<float>(COAST_DISTANCE_MAX))));
+    }
+    pyramid_ = std::make_unique<TerrainPyramid>(heights(), terrain_map());
+}
+
+// Takes ownership of tile data loaded from disk. Each array must hold size * size tiles.
+IslandData::IslandData(uint32_t seed, uint16_t size, uint16_t region_count, std::vector<uint16_t> heights, std::vector<uint16_t> regions,
+    std::vector<uint8_t> terrain, std::vector<uint8_t> coast_distances, std::vector<PointOfInterest> points_of_interest) :
+    coast_distances_(std::move(coast_distances)), heights_(std::move(heights)), points_of_interest_(std::move(points_of_interest)),
+    region_count_(region_count), regions_(std::move(regions)), seed_(seed), size_(size), terrain_(std::move(terrain))
+{
+    const size_t tiles = size_ * size_;
+    if (heights_.size() != tiles || regions_.size() != tiles || terrain_.size() != tiles || coast_distances_.size() != tiles)
+        throw GuruMeditation("Wrong amount of tile data given to IslandData!", size_);
+    if (region_count > REGION_MAX) throw GuruMeditation("Invalid IslandData region count!", region_count);
+    for (const uint8_t packed : terrain_)
+        if (!valid_terrain(packed)) throw GuruMeditation("Invalid packed terrain byte given to IslandData!", packed);
+    pyramid_ = std::make_unique<TerrainPyramid>(this->heights(), terrain_map());
+}
+
+// Copies an island, giving the copy its own terrain pyramid over its own tiles.
+IslandData::IslandData(const IslandData &other) : coast_distances_(other.coast_distances_), heights_(other.heights_),
+    points_of_interest_(other.points_of_interest_), region_count_(other.region_count_), regions_(other.regions_), seed_(other.seed_), size_(other.size_),
+    terrain_(other.terrain_)
+{ pyramid_ = std::make_unique<TerrainPyramid>(*other.pyramid_, heights(), terrain_map()); }
+
+// Moving is fine, as moved vectors keep their buffers.
+IslandData::IslandData(IslandData&&) = default;
+
+// Destructor, defined where TerrainPyramid is complete.
+IslandData::~IslandData() = default;
+
+// Replays the changes made to this island since it was generated, returning how many were skipped for crossing the coastline. Regions, coast distances
+// and points of interest are all derived from which tiles are land, so changes that would turn water into land or land into water are never applied.
+// The terrain pyramid is updated tile by tile, so this costs in proportion to the size of the delta.
+unsigned int IslandData::apply_delta(const ChunkDelta &delta)
+{
+    unsigned int skipped = 0;
+    for (const auto &[index, terrain] : delta.terrain())
+    {
+        if (index >= terrain_.size()) throw GuruMeditation("Invalid tile in chunk delta!", index, size_);
+        if (!valid_terrain(terrain)) throw GuruMeditation("Invalid packed terrain byte in chunk delta!", terrain);
+        if (is_water(terrain_[index]) != is_water(terrain))
+        {
+            skipped++;
+            continue;
+        }
+        const uint8_t old_terrain = terrain_[index];
+        terrain_[index] = terrain;
+        pyramid_->update_tile(index % size_, index / size_, old_terrain);
+    }
+    return skipped;
+}
+
+// Returns the distance in tiles from a land tile to the nearest water, or from a water tile to the nearest land, clamped to COAST_DISTANCE_MAX.
+uint8_t IslandData::coast_distance(unsigned int x, unsigned int y) const { return coast_distances().at({x, y}); }
+
+// A view over the coast distances.
+IslandGridView<uint8_t> IslandData::coast_distances() const { return IslandGridView<uint8_t>(coast_distances_.data(), size_); }
+
+// Converts a quantized 16-bit height back into a float.
+float IslandData::dequantize_height(uint16_t height)
+{ return QUANTIZE_HEIGHT_MIN + (static_cast<float>(height) / 65535.0f) * (QUANTIZE_HEIGHT_MAX - QUANTIZE_HEIGHT_MIN); }
+
+// Checks if a packed terrain byte is one of the water classes.
+bool IslandData::is_water(uint8_t packed) { return (packed & TERRAIN_CLASS_MASK) <= static_cast<uint8_t>(Terrain::WATER); }
+
+// Returns the (dequantized) height of a tile.
+float IslandData::height(unsigned int x, unsigned int y) const { return dequantize_height(heights().at({x, y})); }
+
+// A view over the quantized height map.
+IslandGridView<uint16_t> IslandData::heights() const { return IslandGridView<uint16_t>(heights_.data(), size_); }
+
+// The number of bytes used by this island's tile data, points of interest and terrain pyramid.
+size_t IslandData::memory_usage() const
+{
+    return (size_ * size_ * ((sizeof(uint16_t) * 2) + (sizeof(uint8_t) * 2))) + (points_of_interest_.size() * sizeof(PointOfInterest)) +
+        pyramid_->memory_usage();
+}
+
+// Read-only access to the settlements and dungeons on this island.
+const std::vector<PointOfInterest>& IslandData::points_of_interest() const { return points_of_interest_; }
+
+// The terrain pyramid, for drawing this island zoomed out.
+const TerrainPyramid& IslandData::pyramid() const { return *pyramid_; }
+
+// Converts a float height into a quantized 16-bit height.
+uint16_t IslandData::quantize_height(float height)
+{
+    const float normalized = (std::clamp(height, QUANTIZE_HEIGHT_MIN, QUANTIZE_HEIGHT_MAX) - QUANTIZE_HEIGHT_MIN) /
+        (QUANTIZE_HEIGHT_MAX - QUANTIZE_HEIGHT_MIN);
+    return static_cast<uint16_t>(std::lround(normalized * 65535.0f));
+}
+
+// Checks if a tile has a river running through it.
+bool IslandData::river(unsigned int x, unsigned int y) const { return terrain_map().at({x, y}) & TERRAIN_FLAG_RIVER; }
+
+// Returns the region (sub-island) ID of a tile.
+uint16_t IslandData::region(unsigned int x, unsigned int y) const { return regions().at({x, y}); }
+
+// The number of valid regions on this island.
+uint16_t IslandData::region_count() const { return region_count_; }
+
+// A view over the region IDs.
+IslandGridView<uint16_t> IslandData::regions() const { return IslandGridView<uint16_t>(regions_.data(), size_); }
+
+// The PRNG seed used to generate this island.
+uint32_t IslandData::seed() const { return seed_; }
+
+// Changes the packed terrain byte of a tile, updating the terrain pyramid to match. Like apply_delta(), this can't move the coastline.
+void IslandData::set_terrain(unsigned int x, unsigned int y, uint8_t terrain)
+{
+    if (x >= size_ || y >= size_) throw GuruMeditation("Invalid tile coords for IslandData::set_terrain!", x, y);
+    if (!valid_terrain(terrain)) throw GuruMeditation("Invalid packed terrain byte for IslandData::set_terrain!", terrain);
+    uint8_t &tile = terrain_[(y * size_) + x];
+    if (is_water(tile) != is_water(terrain)) throw GuruMeditation("IslandData::set_terrain cannot move the coastline!", x, y);
+    const uint8_t old_terrain = tile;
+    tile = terrain;
+    pyramid_->update_tile(x, y, old_terrain);
+}
+
+// The width and height of this island map.
+uint16_t IslandData::size() const { return size_; }
+
+// Returns the terrain class of a tile.
+Terrain IslandData::terrain(unsigned int x, unsigned int y) const { return static_cast<Terrain>(terrain_map().at({x, y}) & TERRAIN_CLASS_MASK); }
+
+// A view over the packed terrain bytes.
+IslandGridView<uint8_t> IslandData::terrain_map() const { return IslandGridView<uint8_t>(terrain_.data(), size_); }
+
+// Checks if a packed terrain byte holds a valid Terrain class, and no unknown flags.
+bool IslandData::valid_terrain(uint8_t packed)
+{ return (packed & TERRAIN_CLASS_MASK) <= static_cast<uint8_t>(Terrain::PEAK) && !(packed & ~(TERRAIN_CLASS_MASK | TERRAIN_FLAG_RIVER)); }
+
+}   // namespace gorp
@@ -0,0 +1,101 @@
+// world/island-data.hpp -- Compact, resident storage for generated islands: quantized heights, packed terrain classes and 16-bit region IDs.
+
+// SPDX-FileType: SOURCE
+// SPDX-FileCopyrightText: Copyright 2025 Raine Simmons <gc@gravecat.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include "core/global.hpp"
+#include "procgen/point-of-interest.hpp"
+
+namespace gorp {
+
+class ChunkDelta;       // defined in world/chunk-delta.hpp
+class IslandProcGen;    // defined in procgen/island.hpp
+class TerrainPyramid;   // defined in world/terrain-pyramid.hpp
+
+// The broad terrain classes, derived from the height-map thresholds. Stored in the low bits of each packed terrain byte.
+enum class Terrain : uint8_t { DEEP_WATER, WATER, LOWLAND, LAND, HIGHLAND, MOUNTAIN, PEAK };
+
+// A lightweight, read-only view over a square grid of tiles stored in row-major order. Does not own the data it points to.
+template<typename T> class IslandGridView {
+public:
+                IslandGridView(const T* data, uint16_t size) : data_(data), size_(size) { }
+    const T&    operator()(unsigned int x, unsigned int y) const { return data_[(y * size_) + x]; }     // Unchecked access to a tile.
+    const T&    at(Vector2u pos) const  // Bounds-checked access to a tile.
+    {
+        if (pos.x >= size_ || pos.y >= size_) throw GuruMeditation("IslandGridView given invalid coords", pos.x, pos.y);
+        return data_[(pos.y * size_) + pos.x];
+    }
+    const T*    row(unsigned int y) const { return data_ + (y * size_); }   // Returns a pointer to the start of a row.
+    uint16_t    size() const { return size_; }  // The width and height of the grid.
+
+private:
+    const T*    data_;  // The viewed data.
+    uint16_t    size_;  // The width and height of the grid.
+};
+
+class IslandData {
+public:
+    static constexpr uint8_t    TERRAIN_CLASS_MASK =    0x07;   // The bits of the packed terrain byte used for the Terrain class.
+    static constexpr uint8_t    TERRAIN_FLAG_RIVER =    0x08;   // Set in the packed terrain byte for river tiles.
+
+    static constexpr uint16_t   REGION_WATER =          0xFFFF; // Region ID for water tiles, which cannot belong to a region.
+    static constexpr uint16_t   REGION_TOO_SMALL =      0xFFFE; // Region ID for land tiles that were part of a sub-island considered too small to count.
+    static constexpr uint16_t   REGION_MAX =            0xFFFD; // The highest valid region ID.
+
+    static constexpr uint8_t    COAST_DISTANCE_MAX =    255;    // Coast distances are clamped to this many tiles.
+
+    static constexpr float      QUANTIZE_HEIGHT_MIN =   -1.0f;  // The lowest height that can be stored; anything lower is clamped.
+    static constexpr float      QUANTIZE_HEIGHT_MAX =   1.0f;   // The highest height that can be stored; anything higher is clamped.
+
+                IslandData() = delete;  // No default constructor.
+                IslandData(const IslandProcGen &island);    // Packs a generated island into compact form.
+                // Takes ownership of tile data loaded from disk. Each array must hold size * size tiles.
+                IslandData(uint32_t seed, uint16_t size, uint16_t region_count, std::vector<uint16_t> heights, std::vector<uint16_t> regions,
+                    std::vector<uint8_t> terrain, std::vector<uint8_t> coast_distances, std::vector<PointOfInterest> points_of_interest);
+                IslandData(const IslandData &other);    // Copies an island, giving the copy its own terrain pyramid over its own tiles.
+                IslandData(IslandData&&);   // Moving is fine, as moved vectors keep their buffers.
+                ~IslandData();  // Destructor, defined where TerrainPyramid is complete.
+    // Replays the changes made to this island since it was generated, returning how many were skipped for crossing the coastline. Regions, coast
+    // distances and points of interest are all derived from which tiles are land, so changes that would turn water into land or land into water are
+    // never applied. The terrain pyramid is updated tile by tile, so this costs in proportion to the size of the delta.
+    unsigned int    apply_delta(const ChunkDelta &delta);
+    // Returns the distance in tiles from a land tile to the nearest water, or from a water tile to the nearest land, clamped to COAST_DISTANCE_MAX.
+    uint8_t     coast_distance(unsigned int x, unsigned int y) const;
+    IslandGridView<uint8_t>     coast_distances() const;    // A view over the coast distances.
+    float       height(unsigned int x, unsigned int y) const;   // Returns the (dequantized) height of a tile.
+    IslandGridView<uint16_t>    heights() const;    // A view over the quantized height map.
+    size_t      memory_usage() const;   // The number of bytes used by this island's tile data, points of interest and terrain pyramid.
+    const std::vector<PointOfInterest>&   points_of_interest() const; // Read-only access to the settlements and dungeons on this island.
+    const TerrainPyramid&       pyramid() const;    // The terrain pyramid, for drawing this island zoomed out.
+    bool        river(unsigned int x, unsigned int y) const;    // Checks if a tile has a river running through it.
+    uint16_t    region(unsigned int x, unsigned int y) const;   // Returns the region (sub-island) ID of a tile.
+    uint16_t    region_count() const;   // The number of valid regions on this island.
+    IslandGridView<uint16_t>    regions() const;    // A view over the region IDs.
+    uint32_t    seed() const;           // The PRNG seed used to generate this island.
+    // Changes the packed terrain byte of a tile, updating the terrain pyramid to match. Like apply_delta(), this can't move the coastline.
+    void        set_terrain(unsigned int x, unsigned int y, uint8_t terrain);
+    uint16_t    size() const;           // The width and height of this island map.
+    Terrain     terrain(unsigned int x, unsigned int y) const;  // Returns the terrain class of a tile.
+    IslandGridView<uint8_t>     terrain_map() const;    // A view over the packed terrain bytes.
+
+    static float    dequantize_height(uint16_t height); // Converts a quantized 16-bit height back into a float.
+    static bool     is_water(uint8_t packed);           // Checks if a packed terrain byte is one of the water classes.
+    static uint16_t quantize_height(float height);      // Converts a float height into a quantized 16-bit height.
+    static bool     valid_terrain(uint8_t packed);      // Checks if a packed terrain byte holds a valid Terrain class, and no unknown flags.
+
+private:
+    std::vector<uint8_t>    coast_distances_;   // Coast distances for each tile.
+    std::vector<uint16_t>   heights_;       // Quantized 16-bit heights for each tile.
+    std::vector<PointOfInterest>        points_of_interest_;    // The settlements and dungeons on this island.
+    std::unique_ptr<TerrainPyramid>         pyramid_;   // Summaries of the terrain at every zoom level, built from the tile data.
+    uint16_t                region_count_;  // The number of valid regions on this island.
+    std::vector<uint16_t>   regions_;       // Region (sub-island) IDs for each tile.
+    uint32_t                seed_;          // The PRNG seed used to generate this island.
+    uint16_t                size_;          // The width and height of this island map.
+    std::vector<uint8_t>    terrain_;       // Packed terrain bytes for each tile.
+};
+
+}   // namespace gorp
@@ -0,0 +1,256 @@
+// world/pathfinding.cpp -- A* and jump-point search over island tiles, with region-based reachability checks and reusable per-thread search buffers.
+
+// SPDX-FileType: SOURCE
+// SPDX-FileCopyrightText: Copyright 2025 Raine Simmons <gc@gravecat.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <algorithm>
+#include <cmath>
+
+#include "world/island-data.hpp"
+#include "world/pathfinding.hpp"
+
+namespace gorp {
+namespace pathfinding {
+
+static constexpr uint32_t   NONE =      UINT32_MAX; // Marks a tile with no parent, or a jump that found nothing.
+static constexpr float      SQRT2 =     1.41421356f;    // The length of a diagonal step.
+
+// An entry in the open list. The comparison is reversed, so that the standard heap functions give the lowest estimate first, and ties are broken by tile
+// index so that the path found never depends on anything but the map.
+struct OpenNode
+{
+    float       estimate;   // The cost so far, plus the heuristic estimate of the cost remaining.
+    uint32_t    index;      // The tile index.
+
+    bool    operator<(const OpenNode &other) const { return (estimate != other.estimate ? estimate > other.estimate : index > other.index); }
+};
+
+// Checks which tiles can be walked on, treating anything off the edge of the map as impassable.
+struct Passability
+{
+    const TerrainCosts  &costs;     // The cost of each terrain class.
+    int                 size;       // The width and height of the map.
+    const uint8_t*      terrain;    // The packed terrain bytes.
+
+    uint8_t operator()(int x, int y) const  // Returns the cost of moving onto a tile, or 0 if it's impassable.
+    {
+        if (x < 0 || y < 0 || x >= size || y >= size) return 0;
+        return costs[terrain[(y * size) + x] & IslandData::TERRAIN_CLASS_MASK];
+    }
+};
+
+// Buffers reused from one search to the next on the same thread, so that searching doesn't allocate once they've grown to the largest map searched.
+// Rather than being cleared, each tile is stamped with the ID of the search that last touched it, and anything with an older stamp is treated as unseen.
+struct SearchScratch
+{
+    std::vector<uint32_t>   closed;     // The ID of the last search to close each tile.
+    std::vector<float>      cost;       // The cheapest known cost to reach each tile, if seen in this search.
+    std::vector<OpenNode>   open;       // The open list, as a binary heap.
+    std::vector<uint32_t>   parent;     // The tile each tile was reached from, if seen in this search.
+    uint32_t                search_id = 0;  // The ID of the current search.
+    std::vector<uint32_t>   seen;       // The ID of the last search to reach each tile.
+};
+
+// Returns the octile distance between two tiles: the length of the shortest 8-way path with nothing in the way.
+static float octile(uint32_t ax, uint32_t ay, uint32_t bx, uint32_t by)
+{
+    const uint32_t dx = (ax > bx ? ax - bx : bx - ax), dy = (ay > by ? ay - by : by - ay);
+    return (std::max(dx, dy) - std::min(dx, dy)) + (std::min(dx, dy) * SQRT2);
+}
+
+// Returns this thread's search buffers, ready for a new search over the given number of tiles.
+static SearchScratch& scratch(uint32_t tiles)
+{
+    static thread_local SearchScratch buffers;
+    if (buffers.seen.size() < tiles)
+    {
+        buffers.closed.resize(tiles, 0);
+        buffers.cost.resize(tiles);
+        buffers.parent.resize(tiles);
+        buffers.seen.resize(tiles, 0);
+    }
+    if (!++buffers.search_id)   // The stamps have wrapped around, so old ones could be mistaken for new ones.
+    {
+        std::fill(buffers.closed.begin(), buffers.closed.end(), 0);
+        std::fill(buffers.seen.begin(), buffers.seen.end(), 0);
+        buffers.search_id = 1;
+    }
+    buffers.open.clear();
+    return buffers;
+}
+
+// Scans from (x, y) in direction (dx, dy) for the next jump point: the goal, or a tile with a neighbour that can't be reached more cheaply some other
+// way. Diagonal scans also stop wherever a straight scan from them would find something. Returns the tile index, or NONE if the scan hits a wall.
+static uint32_t jump(const Passability &passable, int x, int y, int dx, int dy, Vector2u goal)
+{
+    while (true)
+    {
+        if (!passable(x, y)) return NONE;
+        if (x == static_cast<int>(goal.x) && y == static_cast<int>(goal.y)) return (y * passable.size) + x;
+        if (dx && dy)
+        {
+            if (jump(passable, x + dx, y, dx, 0, goal) != NONE || jump(passable, x, y + dy, 0, dy, goal) != NONE) return (y * passable.size) + x;
+        }
+        else if (dx)
+        {
+            if ((passable(x, y - 1) && !passable(x - dx, y - 1)) || (passable(x, y + 1) && !passable(x - dx, y + 1))) return (y * passable.size) + x;
+        }
+        else if ((passable(x - 1, y) && !passable(x - 1, y - dy)) || (passable(x + 1, y) && !passable(x + 1, y - dy))) return (y * passable.size) + x;
+
+        // Diagonal moves can't cut corners, so both of the tiles beside the move must be passable. For straight moves, this just checks the tile ahead.
+        if (!passable(x + dx, y) || !passable(x, y + dy)) return NONE;
+        x += dx;
+        y += dy;
+    }
+}
+
+// The search shared by astar() and jump_point(). Both are A* at heart; they differ only in which tiles are added to the open list from each tile.
+static bool search(const IslandData &island, Vector2u start, Vector2u goal, std::vector<Vector2u> &path, const TerrainCosts &costs, bool jump_points)
+{
+    path.clear();
+    const uint16_t size = island.size();
+    if (start.x >= size || start.y >= size) throw GuruMeditation("Invalid pathfinding start", start.x, start.y);
+    if (goal.x >= size || goal.y >= size) throw GuruMeditation("Invalid pathfinding goal", goal.x, goal.y);
+    const Passability passable = { costs, size, island.terrain_map().row(0) };
+    if (!passable(start.x, start.y) || !passable(goal.x, goal.y)) return false;
+    // Regions only say anything about paths over land, so they can't rule a path out if it's allowed to cross water.
+    if (!costs[static_cast<uint8_t>(Terrain::DEEP_WATER)] && !costs[static_cast<uint8_t>(Terrain::WATER)] && !reachable(island, start, goal)) return false;
+
+    // The heuristic must never overestimate, so it assumes the whole way is over the cheapest terrain.
+    uint8_t cheapest = UINT8_MAX;
+    for (auto cost : costs)
+        if (cost) cheapest = std::min(cheapest, cost);
+    auto heuristic = [cheapest, goal](uint32_t x, uint32_t y) { return octile(x, y, goal.x, goal.y) * cheapest; };
+
+    SearchScratch &s = scratch(size * size);
+    const uint32_t id = s.search_id, start_index = (start.y * size) + start.x, goal_index = (goal.y * size) + goal.x;
+    auto reach = [&s, id, &heuristic, size](uint32_t from, uint32_t to, float cost)
+    {
+        if (s.closed[to] == id || (s.seen[to] == id && s.cost[to] <= cost)) return;
+        s.seen[to] = id;
+        s.cost[to] = cost;
+        s.parent[to] = from;
+        s.open.push_back({cost + heuristic(to % size, to / size), to});
+        std::push_heap(s.open.begin(), s.open.end());
+    };
+    reach(NONE, start_index, 0.0f);
+
+    while (s.open.size())
+    {
+        std::pop_heap(s.open.begin(), s.open.end());
+        const uint32_t index = s.open.back().index;
+        s.open.pop_back();
+        if (s.closed[index] == id) continue;    // A stale entry, for a tile since reached more cheaply.
+        s.closed[index] = id;
+        if (index == goal_index) break;
+
+        const int x = index % size, y = index / size;
+        const float cost = s.cost[index];
+        if (!jump_points)
+        {
+            for (int dy = -1; dy <= 1; dy++)
+            {
+                for (int dx = -1; dx <= 1; dx++)
+                {
+                    if ((!dx && !dy) || !passable(x + dx, y + dy)) continue;
+                    if (dx && dy && (!passable(x + dx, y) || !passable(x, y + dy))) continue;
+                    reach(index, ((y + dy) * size) + x + dx, cost + (passable(x + dx, y + dy) * (dx && dy ? SQRT2 : 1.0f)));
+                }
+            }
+            continue;
+        }
+
+        // Jump-point search only looks in the directions that could lead somewhere the parent couldn't reach just as cheaply by itself: straight on,
+        // the sides, and the diagonals between them. The start tile has no parent, so every direction is open from there.
+        int directions[8][2];
+        int direction_count = 0;
+        auto add_direction = [&directions, &direction_count](int dx, int dy) { directions[direction_count][0] = dx; directions[direction_count++][1] = dy; };
+        if (s.parent[index] == NONE)
+        {
+            for (int dy = -1; dy <= 1; dy++)
+                for (int dx = -1; dx <= 1; dx++)
+                    if ((dx || dy) && (!dx || !dy || (passable(x + dx, y) && passable(x, y + dy)))) add_direction(dx, dy);
+        }
+        else
+        {
+            const int px = s.parent[index] % size, py = s.parent[index] / size;
+            const int dx = (x > px) - (x < px), dy = (y > py) - (y < py);
+            if (dx && dy)
+            {
+                const bool side_x = passable(x + dx, y), side_y = passable(x, y + dy);
+                if (side_y) add_direction(0, dy);
+                if (side_x) add_direction(dx, 0);
+                if (side_x && side_y) add_direction(dx, dy);
+            }
+            else
+            {
+                // Moving straight along one axis; the two sides are along the other.
+                const int sx = (dx ? 0 : 1), sy = (dx ? 1 : 0);
+                const bool ahead = passable(x + dx, y + dy), left = passable(x - sx, y - sy), right = passable(x + sx, y + sy);
+                if (ahead) add_direction(dx, dy);
+                if (ahead && left) add_direction(dx - sx, dy - sy);
+                if (ahead && right) add_direction(dx + sx, dy + sy);
+                if (left) add_direction(-sx, -sy);
+                if (right) add_direction(sx, sy);
+            }
+        }
+        for (int d = 0; d < direction_count; d++)
+        {
+            const uint32_t found = jump(passable, x + directions[d][0], y + directions[d][1], directions[d][0], directions[d][1], goal);
+            if (found != NONE) reach(index, found, cost + (octile(x, y, found % size, found / size) * cheapest));
+        }
+    }
+    if (s.closed[goal_index] != id) return false;
+
+    // Walk back from the goal, filling in the tiles between jump points. With plain A*, each step is already a single tile.
+    for (uint32_t index = goal_index; index != start_index; index = s.parent[index])
+    {
+        const uint32_t parent = s.parent[index];
+        int x = index % size, y = index / size;
+        const int px = parent % size, py = parent / size;
+        while (x != px || y != py)
+        {
+            path.push_back({static_cast<uint32_t>(x), static_cast<uint32_t>(y)});
+            x += (px > x) - (px < x);
+            y += (py > y) - (py < y);
+        }
+    }
+    path.push_back(start);
+    std::reverse(path.begin(), path.end());
+    return true;
+}
+
+// Finds the cheapest 8-way path between two tiles with A*, using the given terrain costs.
+bool astar(const IslandData &island, Vector2u start, Vector2u goal, std::vector<Vector2u> &path, const TerrainCosts &costs)
+{ return search(island, start, goal, path, costs, false); }
+
+// Finds a path with whichever search suits the terrain costs: jump-point search if every passable terrain costs the same, or A* otherwise.
+bool find_path(const IslandData &island, Vector2u start, Vector2u goal, std::vector<Vector2u> &path, const TerrainCosts &costs)
+{
+    uint8_t uniform_cost = 0;
+    for (auto cost : costs)
+    {
+        if (!cost) continue;
+        if (uniform_cost && cost != uniform_cost) return astar(island, start, goal, path, costs);
+        uniform_cost = cost;
+    }
+    return jump_point(island, start, goal, path, costs);
+}
+
+// As astar(), but with jump-point search. Only valid when every passable terrain costs the same.
+bool jump_point(const IslandData &island, Vector2u start, Vector2u goal, std::vector<Vector2u> &path, const TerrainCosts &costs)
+{ return search(island, start, goal, path, costs, true); }
+
+// Checks whether a path between two land tiles could possibly exist, in constant time, by comparing their region (sub-island) IDs. Only meaningful when
+// water is impassable.
+bool reachable(const IslandData &island, Vector2u start, Vector2u goal)
+{
+    // Regions are made of orthogonally-connected tiles, and a diagonal move that can't cut corners never connects anything they don't, so two tiles in
+    // different regions can never be joined. Scraps of land too small to be regions all share the same ID, so that case still needs a search to be sure.
+    const uint16_t start_region = island.region(start.x, start.y), goal_region = island.region(goal.x, goal.y);
+    return start_region != IslandData::REGION_WATER && start_region == goal_region;
+}
+
+}   // namespace pathfinding
+}   // namespace gorp
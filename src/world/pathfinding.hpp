@@ -0,0 +1,42 @@
+// world/pathfinding.hpp -- A* and jump-point search over island tiles, with region-based reachability checks and reusable per-thread search buffers.
+
+// SPDX-FileType: SOURCE
+// SPDX-FileCopyrightText: Copyright 2025 Raine Simmons <gc@gravecat.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <array>
+
+#include "core/global.hpp"
+
+namespace gorp {
+
+class IslandData;   // defined in world/island-data.hpp
+
+namespace pathfinding {
+
+// The cost of moving onto a tile of each Terrain class, indexed by the Terrain enum. A cost of 0 means the terrain is impassable.
+using TerrainCosts = std::array<uint8_t, 7>;
+
+// The default costs: every land tile costs the same, and water is impassable.
+constexpr TerrainCosts  UNIFORM_COSTS = { 0, 0, 1, 1, 1, 1, 1 };
+
+// Finds the cheapest 8-way path between two tiles with A*, using the given terrain costs. Diagonal moves cost sqrt(2) times as much, and can't cut
+// the corner of an impassable tile. On success, fills path with every tile from start to goal (inclusive) and returns true; otherwise, path is cleared.
+bool    astar(const IslandData &island, Vector2u start, Vector2u goal, std::vector<Vector2u> &path, const TerrainCosts &costs = UNIFORM_COSTS);
+
+// Finds a path with whichever search suits the terrain costs: jump-point search if every passable terrain costs the same, or A* otherwise.
+bool    find_path(const IslandData &island, Vector2u start, Vector2u goal, std::vector<Vector2u> &path, const TerrainCosts &costs = UNIFORM_COSTS);
+
+// As astar(), but with jump-point search, which skips over the long runs of open tiles that plain A* would expand one at a time. Only valid when every
+// passable terrain costs the same; the costs here are only used to decide which tiles are passable.
+bool    jump_point(const IslandData &island, Vector2u start, Vector2u goal, std::vector<Vector2u> &path, const TerrainCosts &costs = UNIFORM_COSTS);
+
+// Checks whether a path between two land tiles could possibly exist, in constant time, by comparing their region (sub-island) IDs. Only meaningful when
+// water is impassable. A false result is then definite. A true result is only a maybe if both tiles are on scraps of land too small to be regions, or if
+// the terrain costs split a region.
+bool    reachable(const IslandData &island, Vector2u start, Vector2u goal);
+
+}   // namespace pathfinding
+}   // namespace gorp
@@ -0,0 +1,169 @@
+// world/terrain-pyramid.cpp -- A mipmap-style pyramid of terrain summaries, for drawing zoomed-out overviews without touching every tile.
+
+// SPDX-FileType: SOURCE
+// SPDX-FileCopyrightText: Copyright 2025 Raine Simmons <gc@gravecat.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <algorithm>
+
+#include "world/terrain-pyramid.hpp"
+
+namespace gorp {
+
+// Builds the pyramid from an island's heights and packed terrain bytes. The views must outlive the pyramid.
+TerrainPyramid::TerrainPyramid(IslandGridView<uint16_t> heights, IslandGridView<uint8_t> terrain) : base_heights_(heights.row(0)),
+    base_terrain_(terrain.row(0)), base_size_(heights.size())
+{
+    if (terrain.size() != heights.size()) throw GuruMeditation("TerrainPyramid given mismatched views!", heights.size(), terrain.size());
+
+    // The dominant terrain has to be worked out from the tile counts, not from the dominant terrain of the cells below, which can easily give the wrong
+    // answer. Only the counts for the level below are needed to build the next one, so the lower levels throw them away once they're built; the upper
+    // levels keep them, so a changed tile doesn't have to recount their large cells.
+    std::vector<TerrainCounts> counts, next_counts;
+    uint16_t size = base_size_;
+    while (size > 1)
+    {
+        const uint16_t next_size = (size + 1) / 2;
+        const uint32_t cells = next_size * next_size;
+        Level level;
+        level.size = next_size;
+        level.dominant.resize(cells);
+        level.height_max.resize(cells);
+        level.height_min.resize(cells);
+        next_counts.assign(cells, {});
+
+        for (unsigned int ny = 0; ny < next_size; ny++)
+        {
+            for (unsigned int nx = 0; nx < next_size; nx++)
+            {
+                const uint32_t index = (ny * next_size) + nx;
+                uint16_t lowest = UINT16_MAX, highest = 0;
+                auto &cell_counts = next_counts[index];
+                for (unsigned int sy = ny * 2; sy < std::min<unsigned int>((ny * 2) + 2, size); sy++)
+                {
+                    for (unsigned int sx = nx * 2; sx < std::min<unsigned int>((nx * 2) + 2, size); sx++)
+                    {
+                        const uint32_t source = (sy * size) + sx;
+                        if (levels_.empty())
+                        {
+                            lowest = std::min(lowest, base_heights_[source]);
+                            highest = std::max(highest, base_heights_[source]);
+                            cell_counts[base_terrain_[source] & IslandData::TERRAIN_CLASS_MASK]++;
+                        }
+                        else
+                        {
+                            const Level &below = levels_.back();
+                            lowest = std::min(lowest, below.height_min[source]);
+                            highest = std::max(highest, below.height_max[source]);
+                            for (unsigned int t = 0; t < TERRAIN_CLASSES; t++)
+                                cell_counts[t] += counts[source][t];
+                        }
+                    }
+                }
+                level.dominant[index] = dominant(cell_counts);
+                level.height_max[index] = highest;
+                level.height_min[index] = lowest;
+            }
+        }
+        if (levels_.size() + 1 >= COUNTS_LEVEL_MIN) level.counts = next_counts;
+        levels_.push_back(std::move(level));
+        counts.swap(next_counts);
+        size = next_size;
+    }
+}
+
+// Copies another pyramid, for a copy of its island. The views must hold the same tiles as the original's, and outlive the pyramid.
+TerrainPyramid::TerrainPyramid(const TerrainPyramid &other, IslandGridView<uint16_t> heights, IslandGridView<uint8_t> terrain) :
+    base_heights_(heights.row(0)), base_terrain_(terrain.row(0)), base_size_(other.base_size_), levels_(other.levels_)
+{
+    if (heights.size() != base_size_ || terrain.size() != base_size_) throw GuruMeditation("TerrainPyramid copy given mismatched views!", base_size_);
+}
+
+// Returns the summary for a single cell.
+TerrainSummary TerrainPyramid::cell(unsigned int level, unsigned int x, unsigned int y) const
+{
+    const uint16_t size = level_size(level);
+    if (x >= size || y >= size) throw GuruMeditation("Invalid TerrainPyramid coords!", x, y);
+    const uint32_t index = (y * size) + x;
+    if (!level)
+    {
+        const uint16_t height = base_heights_[index];
+        return { static_cast<Terrain>(base_terrain_[index] & IslandData::TERRAIN_CLASS_MASK), height, height };
+    }
+    const Level &cells = levels_.at(level - 1);
+    return { static_cast<Terrain>(cells.dominant[index]), cells.height_max[index], cells.height_min[index] };
+}
+
+// Picks the dominant terrain class from a cell's terrain counts.
+uint8_t TerrainPyramid::dominant(const TerrainCounts &counts)
+{
+    unsigned int dominant = TERRAIN_CLASSES - 1;
+    for (unsigned int t = TERRAIN_CLASSES - 1; t-- > 0;)
+        if (counts[t] > counts[dominant]) dominant = t;
+    return dominant;
+}
+
+// The number of levels, including level 0.
+unsigned int TerrainPyramid::level_count() const { return levels_.size() + 1; }
+
+// Returns the most detailed level that fits in the specified number of cells across, for drawing the whole island in that space.
+unsigned int TerrainPyramid::level_for_size(uint16_t cells) const
+{
+    unsigned int level = 0;
+    while (level + 1 < level_count() && level_size(level) > cells)
+        level++;
+    return level;
+}
+
+// The width and height of a level, in cells.
+uint16_t TerrainPyramid::level_size(unsigned int level) const
+{
+    if (!level) return base_size_;
+    if (level > levels_.size()) throw GuruMeditation("Invalid TerrainPyramid level!", level, levels_.size());
+    return levels_[level - 1].size;
+}
+
+// The number of bytes used by the levels above 0.
+size_t TerrainPyramid::memory_usage() const
+{
+    size_t bytes = 0;
+    for (const auto &level : levels_)
+        bytes += (level.size * level.size * (sizeof(uint8_t) + (sizeof(uint16_t) * 2))) + (level.counts.size() * sizeof(TerrainCounts));
+    return bytes;
+}
+
+// Updates the cells above a tile whose packed terrain byte has just changed, given the byte it held before. Its height must not have changed.
+void TerrainPyramid::update_tile(unsigned int x, unsigned int y, uint8_t old_terrain)
+{
+    if (x >= base_size_ || y >= base_size_) throw GuruMeditation("Invalid TerrainPyramid coords!", x, y);
+    const unsigned int old_class = old_terrain & IslandData::TERRAIN_CLASS_MASK;
+    const unsigned int new_class = base_terrain_[(y * base_size_) + x] & IslandData::TERRAIN_CLASS_MASK;
+    if (old_class == new_class) return;
+
+    // Only the one cell above the tile on each level can change. The cells on the lower levels are small enough to just count again, and the upper levels
+    // keep their counts, which only need the one tile moving from the old class to the new.
+    for (unsigned int level = 1; level <= levels_.size(); level++)
+    {
+        Level &cells = levels_[level - 1];
+        const unsigned int cell_x = x >> level, cell_y = y >> level;
+        const uint32_t index = (cell_y * cells.size) + cell_x;
+        if (cells.counts.size())
+        {
+            TerrainCounts &cell_counts = cells.counts[index];
+            cell_counts[old_class]--;
+            cell_counts[new_class]++;
+            cells.dominant[index] = dominant(cell_counts);
+            continue;
+        }
+
+        TerrainCounts cell_counts{};
+        const unsigned int x_end = std::min<unsigned int>((cell_x + 1) << level, base_size_);
+        const unsigned int y_end = std::min<unsigned int>((cell_y + 1) << level, base_size_);
+        for (unsigned int ty = cell_y << level; ty < y_end; ty++)
+            for (unsigned int tx = cell_x << level; tx < x_end; tx++)
+                cell_counts[base_terrain_[(ty * base_size_) + tx] & IslandData::TERRAIN_CLASS_MASK]++;
+        cells.dominant[index] = dominant(cell_counts);
+    }
+}
+
+}   // namespace gorp
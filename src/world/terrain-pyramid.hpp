@@ -0,0 +1,68 @@
+// world/terrain-pyramid.hpp -- A mipmap-style pyramid of terrain summaries, for drawing zoomed-out overviews without touching every tile.
+
+// SPDX-FileType: SOURCE
+// SPDX-FileCopyrightText: Copyright 2025 Raine Simmons <gc@gravecat.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <array>
+
+#include "core/global.hpp"
+#include "world/island-data.hpp"
+
+namespace gorp {
+
+// A summary of a square block of tiles.
+struct TerrainSummary
+{
+    Terrain     dominant;   // The most common terrain class in the block. Ties go to the higher class, so land wins over water.
+    uint16_t    height_max; // The highest quantized height in the block.
+    uint16_t    height_min; // The lowest quantized height in the block.
+};
+
+// Level 0 is the island itself, and each level above it halves the width and height, with each cell summarizing a 2x2 block of cells from the level
+// below (or fewer, along the edges of odd-sized levels). The top level is a single cell covering the whole island. Every level above 0 adds up to a
+// third of the tile data's size again, at most, plus under 3% for the terrain counts kept by the upper levels.
+class TerrainPyramid {
+public:
+                TerrainPyramid() = delete;  // No default constructor.
+                // Builds the pyramid from an island's heights and packed terrain bytes. The views must outlive the pyramid.
+                TerrainPyramid(IslandGridView<uint16_t> heights, IslandGridView<uint8_t> terrain);
+                // Copies another pyramid, for a copy of its island. The views must hold the same tiles as the original's, and outlive the pyramid.
+                TerrainPyramid(const TerrainPyramid &other, IslandGridView<uint16_t> heights, IslandGridView<uint8_t> terrain);
+                TerrainPyramid(const TerrainPyramid&) = delete; // No plain copying, as the copy would point into the original island's tiles.
+    TerrainSummary  cell(unsigned int level, unsigned int x, unsigned int y) const; // Returns the summary for a single cell.
+    unsigned int    level_count() const;    // The number of levels, including level 0.
+    // Returns the most detailed level that fits in the specified number of cells across, for drawing the whole island in that space.
+    unsigned int    level_for_size(uint16_t cells) const;
+    uint16_t        level_size(unsigned int level) const;   // The width and height of a level, in cells.
+    size_t          memory_usage() const;   // The number of bytes used by the levels above 0.
+    // Updates the cells above a tile whose packed terrain byte has just changed, given the byte it held before. Its height must not have changed.
+    void            update_tile(unsigned int x, unsigned int y, uint8_t old_terrain);
+
+private:
+    static constexpr unsigned int   COUNTS_LEVEL_MIN =  4;  // Levels from this one up keep the terrain counts of their cells, for update_tile().
+    static constexpr unsigned int   TERRAIN_CLASSES =   static_cast<unsigned int>(Terrain::PEAK) + 1;   // The number of terrain classes.
+
+    using TerrainCounts = std::array<uint32_t, TERRAIN_CLASSES>;    // The number of tiles of each terrain class in a cell.
+
+    // A single level above 0. The three arrays are kept separate, so that drawing only the dominant terrain never has to touch the heights.
+    struct Level
+    {
+        std::vector<TerrainCounts>  counts; // The terrain counts of each cell, only kept from COUNTS_LEVEL_MIN up.
+        std::vector<uint8_t>    dominant;   // The dominant terrain class of each cell.
+        std::vector<uint16_t>   height_max; // The highest quantized height in each cell.
+        std::vector<uint16_t>   height_min; // The lowest quantized height in each cell.
+        uint16_t                size;       // The width and height of this level.
+    };
+
+    static uint8_t      dominant(const TerrainCounts &counts);  // Picks the dominant terrain class from a cell's terrain counts.
+
+    const uint16_t*     base_heights_;  // The island's quantized heights, which double as level 0.
+    const uint8_t*      base_terrain_;  // The island's packed terrain bytes, which double as level 0.
+    uint16_t            base_size_;     // The width and height of the island.
+    std::vector<Level>  levels_;        // Levels 1 and above.
+};
+
+}   // namespace gorp
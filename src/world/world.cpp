@@ -0,0 +1,340 @@
+// world/world.cpp -- The game world: an archipelago divided into fixed-size chunks, each one an island, streamed in and out of memory around the player.
+
+// SPDX-FileType: SOURCE
+// SPDX-FileCopyrightText: Copyright 2025 Raine Simmons <gc@gravecat.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <algorithm>
+
+#include "core/core.hpp"
+#include "procgen/island.hpp"
+#include "procgen/island-cache.hpp"
+#include "util/math/rng.hpp"
+#include "util/system/parallel.hpp"
+#include "world/island-data.hpp"
+#include "world/world.hpp"
+
+namespace gorp {
+
+// Creates a new world from the specified seed, keeping resident chunks within the memory budget (in bytes) where possible.
+World::World(uint32_t seed, size_t memory_budget) : focus_(0, 0), memory_budget_(memory_budget), memory_usage_(0), seed_(seed), stopping_(false)
+{
+    // The main thread is kept free for the game itself, so the background threads get whatever's left, but always at least one.
+    const unsigned int threads = std::clamp<unsigned int>(parallel::thread_count() - 1, 1, WORKER_THREADS_MAX);
+    for (unsigned int i = 0; i < threads; i++)
+        workers_.emplace_back(&World::worker, this);
+}
+
+// Destructor, stops the background threads.
+World::~World()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    work_cv_.notify_all();
+    for (auto &thread : workers_)
+        thread.join();
+}
+
+// Adds a newly-loaded chunk, replaying its delta first. The mutex must be held.
+std::shared_ptr<const IslandData> World::add_resident(uint64_t key, std::shared_ptr<IslandData> data)
+{
+    // The delta is applied here, under the same lock as set_terrain(), so a chunk that was changed while it was still loading never misses the change.
+    auto delta = deltas_.find(key);
+    if (delta != deltas_.end())
+    {
+        const unsigned int skipped = data->apply_delta(delta->second);
+        if (skipped) errors_.push_back("Ignored " + std::to_string(skipped) + " changes to chunk " + std::to_string(key_pos(key).x) + "," +
+            std::to_string(key_pos(key).y) + " that would move the coastline.");
+    }
+    lru_.push_front(key);
+    memory_usage_ += data->memory_usage();
+    resident_[key] = { data, lru_.begin() };
+    evict();
+    return data;
+}
+
+// Returns the specified chunk, loading or generating it on the spot if it isn't resident yet. Blocks if it's currently being loaded in the background.
+std::shared_ptr<const IslandData> World::chunk(Vector2 pos)
+{
+    const uint64_t chunk_key = key(pos);
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true)
+    {
+        auto it = resident_.find(chunk_key);
+        if (it != resident_.end())
+        {
+            touch(it->second);
+            return it->second.data;
+        }
+        if (!in_flight_.count(chunk_key)) break;
+        ready_cv_.wait(lock);   // If the background load fails, the chunk still won't be resident, and we'll try loading it ourselves.
+    }
+
+    queue_.erase(std::remove(queue_.begin(), queue_.end(), chunk_key), queue_.end());
+    in_flight_.insert(chunk_key);
+    lock.unlock();
+    std::shared_ptr<IslandData> data;
+    try { data = load(chunk_key); }
+    catch (...)
+    {
+        lock.lock();
+        in_flight_.erase(chunk_key);
+        ready_cv_.notify_all();
+        throw;
+    }
+    lock.lock();
+    in_flight_.erase(chunk_key);
+    std::shared_ptr<const IslandData> resident;
+    try { resident = add_resident(chunk_key, data); }
+    catch (...)
+    {
+        ready_cv_.notify_all();
+        throw;
+    }
+    ready_cv_.notify_all();
+    return resident;
+}
+
+// As above, but never blocks: returns nullptr if the chunk isn't resident yet.
+std::shared_ptr<const IslandData> World::chunk_if_ready(Vector2 pos)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = resident_.find(key(pos));
+    if (it == resident_.end()) return nullptr;
+    touch(it->second);
+    return it->second.data;
+}
+
+// The island seed for a given chunk, derived from the world seed.
+uint32_t World::chunk_seed(Vector2 pos) const { return RNG(seed_).split("chunk").split(key(pos)).get<uint32_t>(1, UINT32_MAX); }
+
+// Evicts the least-recently-used chunks outside the streaming radius until within the memory budget. The mutex must be held.
+void World::evict()
+{
+    // Chunks are generated deterministically from the world seed, the island cache keeps a copy of every chunk on disk, and any changes are kept in the
+    // chunk's delta, so evicting a chunk never loses anything: it's just dropped from memory, and loaded back in from the cache next time. Anyone still
+    // holding a pointer to it keeps it alive.
+    auto it = lru_.end();
+    while (memory_usage_ > memory_budget_ && it != lru_.begin())
+    {
+        --it;
+        if (in_radius(*it)) continue;
+        auto chunk = resident_.find(*it);
+        memory_usage_ -= chunk->second.data->memory_usage();
+        resident_.erase(chunk);
+        it = lru_.erase(it);
+    }
+}
+
+// The chunk that streaming is currently centred on.
+Vector2 World::focus() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return focus_;
+}
+
+// Checks if a chunk is within the streaming radius of the focus. The mutex must be held.
+bool World::in_radius(uint64_t key) const
+{
+    const Vector2 pos = key_pos(key);
+    return std::abs(pos.x - focus_.x) <= STREAM_RADIUS && std::abs(pos.y - focus_.y) <= STREAM_RADIUS;
+}
+
+// Drops a resident chunk, so it's loaded again with its latest delta. The mutex must be held.
+void World::invalidate(uint64_t key)
+{
+    auto it = resident_.find(key);
+    if (it == resident_.end()) return;
+    memory_usage_ -= it->second.data->memory_usage();
+    lru_.erase(it->second.lru);
+    resident_.erase(it);
+    if (in_radius(key) && !in_flight_.count(key) && std::find(queue_.begin(), queue_.end(), key) == queue_.end())
+    {
+        queue_.push_front(key);
+        work_cv_.notify_all();
+    }
+}
+
+// Packs chunk coordinates into a single key.
+uint64_t World::key(Vector2 pos) { return (static_cast<uint64_t>(static_cast<uint32_t>(pos.x)) << 32) | static_cast<uint32_t>(pos.y); }
+
+// Unpacks chunk coordinates from a key.
+Vector2 World::key_pos(uint64_t key) { return Vector2(static_cast<int32_t>(key >> 32), static_cast<int32_t>(key & 0xFFFFFFFF)); }
+
+// Loads a chunk from the island cache, or generates it. Safe to call from any thread.
+std::shared_ptr<IslandData> World::load(uint64_t key)
+{
+    const uint32_t island_seed = chunk_seed(key_pos(key));
+    IslandCache cache;
+    std::shared_ptr<IslandData> island = cache.load(CHUNK_SIZE, island_seed);
+    if (island) return island;
+
+    const IslandProcGen generated(CHUNK_SIZE, island_seed);
+    core().log(generated.timing_report());
+    auto new_island = std::make_shared<IslandData>(generated);
+    try { cache.save(*new_island); }
+    catch (const std::exception &e)
+    {
+        // Not fatal, as the chunk can always be generated again; but it'll have to be, every time it's loaded.
+        std::lock_guard<std::mutex> lock(mutex_);
+        errors_.push_back("Could not cache chunk: " + std::string(e.what()));
+    }
+    return new_island;
+}
+
+// The memory budget for resident chunks, in bytes.
+size_t World::memory_budget() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return memory_budget_;
+}
+
+// The memory currently used by resident chunks, in bytes.
+size_t World::memory_usage() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return memory_usage_;
+}
+
+// The number of chunks currently in memory.
+size_t World::resident_count() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return resident_.size();
+}
+
+// Restores the changes made to a chunk, such as from a saved game.
+void World::restore_delta(Vector2 pos, ChunkDelta delta)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    const uint64_t chunk_key = key(pos);
+    if (delta.empty()) deltas_.erase(chunk_key);
+    else deltas_[chunk_key] = std::move(delta);
+    invalidate(chunk_key);
+}
+
+// The seed this world was generated from.
+uint32_t World::seed() const { return seed_; }
+
+// Centres streaming on a new chunk, queueing any nearby chunks that aren't yet resident.
+void World::set_focus(Vector2 pos)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    focus_ = pos;
+
+    // Anything still queued from the old focus is dropped, and the new neighbourhood is queued nearest-first, so the chunk the player is about to walk
+    // into is never stuck behind one they've already left behind.
+    std::vector<std::pair<int, uint64_t>> wanted;
+    for (int y = -STREAM_RADIUS; y <= STREAM_RADIUS; y++)
+    {
+        for (int x = -STREAM_RADIUS; x <= STREAM_RADIUS; x++)
+        {
+            const uint64_t chunk_key = key(Vector2(pos.x + x, pos.y + y));
+            if (resident_.count(chunk_key) || in_flight_.count(chunk_key)) continue;
+            wanted.push_back({(x * x) + (y * y), chunk_key});
+        }
+    }
+    std::stable_sort(wanted.begin(), wanted.end(), [](const auto &a, const auto &b) { return a.first < b.first; });
+    queue_.clear();
+    for (const auto &chunk : wanted)
+        queue_.push_back(chunk.second);
+    evict();
+    work_cv_.notify_all();
+}
+
+// Sets a new memory budget for resident chunks, in bytes.
+void World::set_memory_budget(size_t budget)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    memory_budget_ = budget;
+    evict();
+}
+
+// Changes the packed terrain byte of a tile within a chunk, recording the change in the chunk's delta, and making it in the resident chunk too. Water can
+// only become another kind of water, and land another kind of land, as regions and coast distances are never recomputed.
+void World::set_terrain(Vector2 pos, unsigned int x, unsigned int y, uint8_t terrain)
+{
+    if (x >= CHUNK_SIZE || y >= CHUNK_SIZE) throw GuruMeditation("Invalid tile coords for set_terrain!", x, y);
+    if (!IslandData::valid_terrain(terrain)) throw GuruMeditation("Invalid packed terrain byte for set_terrain!", terrain);
+    // Every change stays on the same side of the coastline, so the tile's current terrain is on the same side as the generated terrain.
+    if (IslandData::is_water(chunk(pos)->terrain_map()(x, y)) != IslandData::is_water(terrain))
+        throw GuruMeditation("set_terrain cannot move the coastline!", x, y);
+    std::lock_guard<std::mutex> lock(mutex_);
+    const uint64_t chunk_key = key(pos);
+    deltas_[chunk_key].set_terrain((y * CHUNK_SIZE) + x, terrain);
+    dirty_deltas_.insert(chunk_key);
+
+    // If the chunk has been evicted since, the change is replayed along with the rest of its delta when it's next loaded. Otherwise, the resident chunk
+    // is changed directly. Anything still holding it was given it read-only, so it keeps the old copy, and the change goes into a new one; the copy is
+    // only skipped when nothing else holds the chunk, which can't change while the mutex is held, as every other pointer to it comes from resident_.
+    auto it = resident_.find(chunk_key);
+    if (it == resident_.end()) return;
+    auto &data = it->second.data;
+    if (data.use_count() > 1) data = std::make_shared<IslandData>(*data);
+    data->set_terrain(x, y, terrain);
+}
+
+// Copies the delta of every chunk changed since the last call, for saving.
+std::vector<std::pair<Vector2, ChunkDelta>> World::take_dirty_deltas()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<std::pair<Vector2, ChunkDelta>> dirty;
+    for (const uint64_t chunk_key : dirty_deltas_)
+        dirty.push_back({key_pos(chunk_key), deltas_[chunk_key]});
+    dirty_deltas_.clear();
+    return dirty;
+}
+
+// Marks a resident chunk as the most recently used. The mutex must be held.
+void World::touch(ResidentChunk &chunk) { lru_.splice(lru_.begin(), lru_, chunk.lru); }
+
+// Reports any errors from the background threads, and evicts chunks if over the memory budget. Call this once per turn.
+void World::update()
+{
+    std::vector<std::string> errors;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        errors.swap(errors_);
+        evict();
+    }
+    for (const auto &error : errors)
+        core().nonfatal(error, Core::CORE_WARN);
+}
+
+// The background thread loop, loading queued chunks until the World is destroyed.
+void World::worker()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true)
+    {
+        work_cv_.wait(lock, [this] { return stopping_ || queue_.size(); });
+        if (stopping_) return;
+        const uint64_t chunk_key = queue_.front();
+        queue_.pop_front();
+        in_flight_.insert(chunk_key);
+        lock.unlock();
+
+        std::shared_ptr<IslandData> data;
+        std::string error;
+        try { data = load(chunk_key); }
+        catch (const std::exception &e) { error = e.what(); }
+
+        lock.lock();
+        in_flight_.erase(chunk_key);
+        if (data)
+        {
+            try { add_resident(chunk_key, data); }
+            catch (const std::exception &e)
+            {
+                error = e.what();
+                data.reset();
+            }
+        }
+        if (!data) errors_.push_back("Could not load chunk " + std::to_string(key_pos(chunk_key).x) + "," + std::to_string(key_pos(chunk_key).y) + ": " + error);
+        ready_cv_.notify_all();
+    }
+}
+
+}   // namespace gorp
@@ -0,0 +1,91 @@
+// world/world.hpp -- The game world: an archipelago divided into fixed-size chunks, each one an island, streamed in and out of memory around the player.
+
+// SPDX-FileType: SOURCE
+// SPDX-FileCopyrightText: Copyright 2025 Raine Simmons <gc@gravecat.com>
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "core/global.hpp"
+#include "world/chunk-delta.hpp"
+
+namespace gorp {
+
+class IslandData;   // defined in world/island-data.hpp
+
+class World {
+public:
+    static constexpr uint16_t   CHUNK_SIZE =            128;    // The width and height of each chunk, in tiles. Each chunk is a single island.
+    static constexpr int        STREAM_RADIUS =         1;      // Chunks up to this many chunks away from the focus are loaded ahead of time.
+    static constexpr unsigned int   WORKER_THREADS_MAX =    2;  // The most background threads used to generate and load chunks.
+
+                World() = delete;   // No default constructor.
+                // Creates a new world from the specified seed, keeping resident chunks within the memory budget (in bytes) where possible.
+                World(uint32_t seed, size_t memory_budget);
+                World(const World&) = delete;   // No copying, as the background threads hold a pointer to this World.
+                ~World();   // Destructor, stops the background threads.
+    // Returns the specified chunk, loading or generating it on the spot if it isn't resident yet. Blocks if it's currently being loaded in the background.
+    std::shared_ptr<const IslandData>   chunk(Vector2 pos);
+    // As above, but never blocks: returns nullptr if the chunk isn't resident yet.
+    std::shared_ptr<const IslandData>   chunk_if_ready(Vector2 pos);
+    uint32_t    chunk_seed(Vector2 pos) const;  // The island seed for a given chunk, derived from the world seed.
+    Vector2     focus() const;          // The chunk that streaming is currently centred on.
+    size_t      memory_budget() const;  // The memory budget for resident chunks, in bytes.
+    size_t      memory_usage() const;   // The memory currently used by resident chunks, in bytes.
+    size_t      resident_count() const; // The number of chunks currently in memory.
+    void        restore_delta(Vector2 pos, ChunkDelta delta);   // Restores the changes made to a chunk, such as from a saved game.
+    uint32_t    seed() const;           // The seed this world was generated from.
+    void        set_focus(Vector2 pos);             // Centres streaming on a new chunk, queueing any nearby chunks that aren't yet resident.
+    void        set_memory_budget(size_t budget);   // Sets a new memory budget for resident chunks, in bytes.
+    // Changes the packed terrain byte of a tile within a chunk, recording the change in the chunk's delta, and making it in the resident chunk too. Water
+    // can only become another kind of water, and land another kind of land, as regions and coast distances are never recomputed.
+    void        set_terrain(Vector2 pos, unsigned int x, unsigned int y, uint8_t terrain);
+    std::vector<std::pair<Vector2, ChunkDelta>> take_dirty_deltas();    // Copies the delta of every chunk changed since the last call, for saving.
+    void        update();   // Reports any errors from the background threads, and evicts chunks if over the memory budget. Call this once per turn.
+
+private:
+    // A chunk held in memory.
+    struct ResidentChunk
+    {
+        std::shared_ptr<IslandData>         data;   // The chunk's island data. Only ever changed while nothing else holds it (see set_terrain()).
+        std::list<uint64_t>::iterator       lru;    // The chunk's position in the LRU list.
+    };
+
+    // Adds a newly-loaded chunk, replaying its delta first. The mutex must be held.
+    std::shared_ptr<const IslandData>   add_resident(uint64_t key, std::shared_ptr<IslandData> data);
+    void    evict();    // Evicts the least-recently-used chunks outside the streaming radius until within the memory budget. The mutex must be held.
+    bool    in_radius(uint64_t key) const;  // Checks if a chunk is within the streaming radius of the focus. The mutex must be held.
+    void    invalidate(uint64_t key);       // Drops a resident chunk, so it's loaded again with its latest delta. The mutex must be held.
+    static uint64_t key(Vector2 pos);       // Packs chunk coordinates into a single key.
+    static Vector2  key_pos(uint64_t key);  // Unpacks chunk coordinates from a key.
+    std::shared_ptr<IslandData> load(uint64_t key); // Loads a chunk from the island cache, or generates it. Safe to call from any thread.
+    void    touch(ResidentChunk &chunk);    // Marks a resident chunk as the most recently used. The mutex must be held.
+    void    worker();   // The background thread loop, loading queued chunks until the World is destroyed.
+
+    std::unordered_map<uint64_t, ChunkDelta>    deltas_;    // The changes made to each chunk, replayed whenever the chunk is loaded.
+    std::unordered_set<uint64_t>    dirty_deltas_;  // Chunks whose deltas have changed since take_dirty_deltas() was last called.
+    std::vector<std::string>    errors_;    // Errors from the background threads, waiting to be reported on the main thread.
+    Vector2                     focus_;     // The chunk that streaming is centred on.
+    std::unordered_set<uint64_t>    in_flight_; // Chunks currently being loaded, by a background thread or a blocking call to chunk().
+    std::list<uint64_t>         lru_;       // Resident chunks, most recently used first.
+    size_t                      memory_budget_; // The memory budget for resident chunks, in bytes.
+    size_t                      memory_usage_;  // The memory used by resident chunks, in bytes.
+    mutable std::mutex          mutex_;     // Guards everything that the background threads share with the main thread.
+    std::deque<uint64_t>        queue_;     // Chunks waiting to be loaded in the background, nearest first.
+    std::condition_variable     ready_cv_;  // Signalled whenever a chunk finishes loading.
+    std::unordered_map<uint64_t, ResidentChunk> resident_;  // The chunks currently in memory.
+    uint32_t                    seed_;      // The seed this world was generated from.
+    bool                        stopping_;  // Set when the World is being destroyed, to stop the background threads.
+    std::condition_variable     work_cv_;   // Signalled whenever a chunk is queued, or the World is being destroyed.
+    std::vector<std::thread>    workers_;   // The background threads.
+};
+
+}   // namespace gorp